@@ -1,5 +1,6 @@
 #include "KleeGenerator.h"
 
+#include "clang-utils/BitcodeCompiler.h"
 #include "environment/EnvironmentPaths.h"
 #include "exceptions/ExecutionProcessException.h"
 #include "exceptions/FileSystemException.h"
@@ -14,10 +15,13 @@
 
 #include "loguru.h"
 
+#include <regex>
+
 using namespace tests;
 
 static const std::string GENERATION_COMPILE_MAKEFILE = "GenerationCompileMakefile.mk";
 static const std::string GENERATION_KLEE_MAKEFILE = "GenerationKleeMakefile.mk";
+static const std::string GENERATION_KLEE_FILES_MAKEFILE = "GenerationKleeFilesMakefile.mk";
 
 KleeGenerator::KleeGenerator(BaseTestGen *testGen, types::TypesHandler &typesHandler,
                              PathSubstitution filePathsSubstitution)
@@ -179,11 +183,9 @@ KleeGenerator::getCompileCommandsForKlee(const CollectionUtils::MapFileTo<fs::pa
 }
 
 
-Result<fs::path> KleeGenerator::defaultBuild(const fs::path &hintPath,
-                                             const fs::path &sourceFilePath,
-                                             const fs::path &buildDirPath,
-                                             const std::vector<std::string> &flags) {
-    LOG_SCOPE_FUNCTION(DEBUG);
+utbot::CompileCommand KleeGenerator::getDefaultBuildCommand(const fs::path &hintPath,
+                                                           const fs::path &sourceFilePath,
+                                                           const std::vector<std::string> &flags) const {
     auto bitcodeFilePath = testGen->getTargetBuildDatabase()->getBitcodeFile(sourceFilePath);
     auto optionalCommand = getCompileCommandForKlee(hintPath, {}, flags, false);
     if (!optionalCommand.has_value()) {
@@ -196,6 +198,15 @@ Result<fs::path> KleeGenerator::defaultBuild(const fs::path &hintPath,
     auto &command = optionalCommand.value();
     command.setSourcePath(sourceFilePath);
     command.setOutput(bitcodeFilePath);
+    return command;
+}
+
+Result<fs::path> KleeGenerator::defaultBuild(const fs::path &hintPath,
+                                             const fs::path &sourceFilePath,
+                                             const fs::path &buildDirPath,
+                                             const std::vector<std::string> &flags) {
+    LOG_SCOPE_FUNCTION(DEBUG);
+    auto command = getDefaultBuildCommand(hintPath, sourceFilePath, flags);
 
     printer::DefaultMakefilePrinter makefilePrinter;
     auto commandWithChangingDirectory = utbot::CompileCommand(command, true);
@@ -218,6 +229,71 @@ Result<fs::path> KleeGenerator::defaultBuild(const fs::path &hintPath,
     return command.getOutput();
 }
 
+Result<fs::path> KleeGenerator::inProcessBuild(const fs::path &hintPath,
+                                               const fs::path &sourceFilePath,
+                                               const std::vector<std::string> &flags) {
+    auto command = getDefaultBuildCommand(hintPath, sourceFilePath, flags);
+    auto compiled = BitcodeCompiler::getInstance().compile(command);
+    if (!compiled.has_value()) {
+        return defaultBuild(hintPath, sourceFilePath, "", flags);
+    }
+    auto &kleeBitcodeFile = compiled.value();
+    if (!kleeBitcodeFile.isSuccess()) {
+        LOG_S(ERROR) << "Compilation for " << sourceFilePath << " failed.\n"
+                     << "Command: \"" << command.toString() << "\"\n"
+                     << kleeBitcodeFile.getError().value() << "\n";
+    }
+    return kleeBitcodeFile;
+}
+
+CollectionUtils::FileSet
+KleeGenerator::buildInParallel(const std::vector<utbot::CompileCommand> &compileCommands) {
+    LOG_SCOPE_FUNCTION(DEBUG);
+    if (compileCommands.size() == 1) {
+        // nothing to parallelize, while in-process compilation reuses the cached preamble
+        auto compiled = BitcodeCompiler::getInstance().compile(compileCommands.front());
+        // after a crash the file is compiled by make below
+        if (compiled.has_value()) {
+            auto &kleeBitcodeFile = compiled.value();
+            if (kleeBitcodeFile.isSuccess()) {
+                return { kleeBitcodeFile.getOpt().value() };
+            }
+            LOG_S(DEBUG) << "Klee file was not compiled:\n" << kleeBitcodeFile.getError().value();
+            return {};
+        }
+    }
+    printer::DefaultMakefilePrinter makefilePrinter;
+    // failure of one file must not stop compilation of the others
+    makefilePrinter.declareAction(".IGNORE:");
+    std::vector<fs::path> outputs;
+    for (const auto &compileCommand : compileCommands) {
+        fs::path output = compileCommand.getOutput();
+        // success is detected by presence of output, so stale one is removed
+        fs::remove(output);
+        outputs.push_back(output);
+        utbot::CompileCommand commandWithChangingDirectory{compileCommand, true};
+        makefilePrinter.declareTarget(output, {commandWithChangingDirectory.getSourcePath()},
+                                      {commandWithChangingDirectory.toStringWithChangingDirectory()});
+    }
+    makefilePrinter.declareTarget(printer::DefaultMakefilePrinter::TARGET_ALL, outputs, {});
+    fs::path makefile = testGen->serverBuildDir / GENERATION_KLEE_FILES_MAKEFILE;
+    FileSystemUtils::writeToFile(makefile, makefilePrinter.ss.str());
+
+    auto makefileCommand = MakefileUtils::MakefileCommand(testGen->projectContext, makefile,
+                                                          printer::DefaultMakefilePrinter::TARGET_ALL);
+    auto [out, status, _] = makefileCommand.run();
+    ExecUtils::throwIfCancelled();
+    CollectionUtils::FileSet builtFiles;
+    for (const fs::path &output : outputs) {
+        if (fs::exists(output)) {
+            builtFiles.insert(output);
+        }
+    }
+    LOG_IF_S(DEBUG, builtFiles.size() != outputs.size())
+        << "Some klee files were not compiled:\n" << out;
+    return builtFiles;
+}
+
 Result<fs::path> KleeGenerator::defaultBuild(const fs::path &sourceFilePath,
                                              const fs::path &buildDirPath,
                                              const std::vector<std::string> &flags) {
@@ -245,78 +321,188 @@ std::vector<fs::path> KleeGenerator::buildKleeFiles(const tests::TestsMap &tests
     std::vector<fs::path> outFiles;
     LOG_S(DEBUG) << "Building generated klee files...";
     printer::KleePrinter kleePrinter(&typesHandler, testGen->getTargetBuildDatabase(), utbot::Language::UNKNOWN);
+    std::vector<std::string> includeFlags = {
+            CompilationUtils::getIncludePath(Paths::getFlagsDir(testGen->projectContext))};
+    std::vector<std::pair<fs::path, fs::path>> kleeFiles;
+    std::vector<utbot::CompileCommand> compileCommands;
     ExecUtils::doWorkWithProgress(
-            testsMap, testGen->progressWriter, "Building generated klee files",
+            testsMap, testGen->progressWriter, "Writing generated klee files",
             [&](auto const &it) {
                 const auto &[filename, tests] = it;
                 if (lineInfo != nullptr && filename != lineInfo->filePath) {
                     return;
                 }
                 kleePrinter.srcLanguage = Paths::getSourceLanguage(filename);
-                std::vector<std::string> includeFlags = {
-                        CompilationUtils::getIncludePath(Paths::getFlagsDir(testGen->projectContext))};
-                auto buildDirPath =
-                        testGen->getClientCompilationUnitInfo(filename)->getDirectory();
-
                 fs::path kleeFilePath = writeKleeFile(kleePrinter, tests, lineInfo);
-                auto kleeFilesInfo =
-                        testGen->getClientCompilationUnitInfo(
-                                tests.sourceFilePath)->kleeFilesInfo;
-                auto kleeBitcodeFile = defaultBuild(filename, kleeFilePath, buildDirPath, includeFlags);
-                if (kleeBitcodeFile.isSuccess()) {
-                    outFiles.emplace_back(kleeBitcodeFile.getOpt().value());
-                    kleeFilesInfo->setAllAreCorrect(true);
-                    LOG_S(MAX) << "Klee filepath: " << outFiles.back();
-                } else {
-                    if (lineInfo) {
-                        throw BaseException("Couldn't compile klee file for current line.");
-                    }
-                    auto tempKleeFilePath = Paths::addSuffix(kleeFilePath, "_temp");
-                    fs::copy(kleeFilePath, tempKleeFilePath, fs::copy_options::overwrite_existing);
-                    LOG_S(DEBUG)
-                    << "File " << kleeFilePath
-                    << " couldn't be compiled so it's copy is backed up in " << tempKleeFilePath
-                    << ". Proceeding with generating klee file containing restricted number "
-                       "of functions";
-                    std::unordered_set<std::string> correctMethods;
-                    for (const auto &[methodName, methodDescription]: tests.methods) {
-                        fs::path currentKleeFilePath = kleePrinter.writeTmpKleeFile(
-                                tests, testGen->serverBuildDir, pathSubstitution, std::nullopt,
-                                methodDescription.name,
-                                methodDescription.getClassName(),
-                                true, false);
-                        auto currentKleeBitcodeFile =
-                                defaultBuild(filename, currentKleeFilePath, buildDirPath, includeFlags);
-                        if (currentKleeBitcodeFile.isSuccess()) {
-                            correctMethods.insert(methodDescription.name);
-                        } else {
-                            std::stringstream message;
-                            message << "Function '" << methodName
-                                    << "' was skipped, as there was an error in compilation klee file "
-                                       "for it";
-                            LOG_S(WARNING) << message.str();
-                            failedFunctions[filename].emplace_back(message.str());
-                        }
-                    }
-                    kleeFilesInfo->setCorrectMethods(std::move(correctMethods));
-
-                    auto kleeFilePath = writeKleeFile(
-                            kleePrinter, tests, lineInfo,
-                            [&kleeFilesInfo](tests::Tests::MethodDescription const &method) -> bool {
-                                return kleeFilesInfo->isCorrectMethod(method.name);
-                            });
-                    auto kleeBitcodeFile =
-                            defaultBuild(filename, kleeFilePath, buildDirPath, includeFlags);
-                    if (kleeBitcodeFile.isSuccess()) {
-                        outFiles.emplace_back(kleeBitcodeFile.getOpt().value());
-                    } else {
-                        throw BaseException("Couldn't compile klee file from correct methods.");
-                    }
-                }
+                kleeFiles.emplace_back(filename, kleeFilePath);
+                compileCommands.push_back(getDefaultBuildCommand(filename, kleeFilePath, includeFlags));
             });
+
+    if (testGen->progressWriter) {
+        testGen->progressWriter->writeProgress("Building generated klee files");
+    }
+    CollectionUtils::FileSet builtFiles = buildInParallel(compileCommands);
+
+    for (size_t i = 0; i < kleeFiles.size(); i++) {
+        const auto &[filename, kleeFilePath] = kleeFiles[i];
+        const tests::Tests &tests = testsMap.at(filename);
+        kleePrinter.srcLanguage = Paths::getSourceLanguage(filename);
+        auto kleeFilesInfo =
+                testGen->getClientCompilationUnitInfo(
+                        tests.sourceFilePath)->kleeFilesInfo;
+        fs::path kleeBitcodeFile = compileCommands[i].getOutput();
+        if (CollectionUtils::contains(builtFiles, kleeBitcodeFile)) {
+            outFiles.emplace_back(kleeBitcodeFile);
+            kleeFilesInfo->setAllAreCorrect(true);
+            LOG_S(MAX) << "Klee filepath: " << outFiles.back();
+        } else {
+            if (lineInfo) {
+                throw BaseException("Couldn't compile klee file for current line.");
+            }
+            auto tempKleeFilePath = Paths::addSuffix(kleeFilePath, "_temp");
+            fs::copy(kleeFilePath, tempKleeFilePath, fs::copy_options::overwrite_existing);
+            LOG_S(DEBUG)
+            << "File " << kleeFilePath
+            << " couldn't be compiled so it's copy is backed up in " << tempKleeFilePath
+            << ". Proceeding with generating klee file containing restricted number "
+               "of functions";
+            std::unordered_set<std::string> correctMethods =
+                    findCorrectMethods(kleePrinter, tests, includeFlags);
+            for (const auto &[methodName, methodDescription]: tests.methods) {
+                if (!CollectionUtils::contains(correctMethods, methodDescription.name)) {
+                    std::stringstream message;
+                    message << "Function '" << methodName
+                            << "' was skipped, as there was an error in compilation klee file "
+                               "for it";
+                    LOG_S(WARNING) << message.str();
+                    failedFunctions[filename].emplace_back(message.str());
+                }
+            }
+            kleeFilesInfo->setCorrectMethods(std::move(correctMethods));
+
+            auto restrictedKleeFilePath = writeKleeFile(
+                    kleePrinter, tests, lineInfo,
+                    [&kleeFilesInfo](tests::Tests::MethodDescription const &method) -> bool {
+                        return kleeFilesInfo->isCorrectMethod(method.name);
+                    });
+            auto restrictedBitcodeFile =
+                    inProcessBuild(filename, restrictedKleeFilePath, includeFlags);
+            if (restrictedBitcodeFile.isSuccess()) {
+                outFiles.emplace_back(restrictedBitcodeFile.getOpt().value());
+            } else {
+                throw BaseException("Couldn't compile klee file from correct methods.");
+            }
+        }
+    }
     return outFiles;
 }
 
+std::unordered_set<std::string>
+KleeGenerator::getMethodsWithErrors(const std::string &compilerOutput,
+                                    const fs::path &kleeFilePath,
+                                    const printer::KleePrinter::MethodLineRanges &methodLineRanges) {
+    static const std::regex errorRegex(R"(^(.+):(\d+):\d+: (?:fatal )?error: )");
+    std::unordered_set<std::string> methodsWithErrors;
+    std::istringstream output(compilerOutput);
+    std::string line;
+    while (std::getline(output, line)) {
+        std::smatch match;
+        if (!std::regex_search(line, match, errorRegex) ||
+            fs::path(match[1].str()).filename() != kleeFilePath.filename()) {
+            continue;
+        }
+        size_t errorLine = std::stoul(match[2].str());
+        for (const auto &[methodName, lines] : methodLineRanges) {
+            if (lines.first <= errorLine && errorLine <= lines.second) {
+                methodsWithErrors.insert(methodName);
+            }
+        }
+    }
+    return methodsWithErrors;
+}
+
+Result<fs::path>
+KleeGenerator::buildKleeFileForMethods(printer::KleePrinter &kleePrinter,
+                                       const tests::Tests &tests,
+                                       const std::vector<std::string> &methods,
+                                       const std::vector<std::string> &includeFlags,
+                                       std::unordered_set<std::string> &methodsWithErrors) {
+    std::unordered_set<std::string> methodSet(methods.begin(), methods.end());
+    fs::path kleeFilePath = writeKleeFile(
+            kleePrinter, tests, nullptr,
+            [&methodSet](tests::Tests::MethodDescription const &method) -> bool {
+                return CollectionUtils::contains(methodSet, method.name);
+            });
+    auto kleeBitcodeFile = inProcessBuild(tests.sourceFilePath, kleeFilePath, includeFlags);
+    if (!kleeBitcodeFile.isSuccess()) {
+        methodsWithErrors = getMethodsWithErrors(kleeBitcodeFile.getError().value(), kleeFilePath,
+                                                 kleePrinter.getMethodLineRanges());
+    }
+    return kleeBitcodeFile;
+}
+
+void KleeGenerator::collectCorrectMethods(printer::KleePrinter &kleePrinter,
+                                          const tests::Tests &tests,
+                                          const std::vector<std::string> &methods,
+                                          const std::unordered_set<std::string> &methodsWithErrors,
+                                          const std::vector<std::string> &includeFlags,
+                                          std::unordered_set<std::string> &correctMethods) {
+    if (methods.size() <= 1) {
+        return;
+    }
+    ExecUtils::throwIfCancelled();
+    std::vector<std::string> methodsWithoutErrors;
+    for (const auto &method : methods) {
+        if (!CollectionUtils::contains(methodsWithErrors, method)) {
+            methodsWithoutErrors.push_back(method);
+        }
+    }
+    if (methodsWithoutErrors.empty()) {
+        return;
+    }
+    std::vector<std::vector<std::string>> parts;
+    if (methodsWithoutErrors.size() < methods.size()) {
+        // diagnostics point inside wrappers of particular methods, so only they are dropped
+        parts.push_back(std::move(methodsWithoutErrors));
+    } else {
+        // errors can't be attributed to methods, so the halves are checked separately
+        auto middle = methods.begin() + methods.size() / 2;
+        parts.emplace_back(methods.begin(), middle);
+        parts.emplace_back(middle, methods.end());
+    }
+    for (const auto &part : parts) {
+        std::unordered_set<std::string> partErrors;
+        if (buildKleeFileForMethods(kleePrinter, tests, part, includeFlags, partErrors)
+                .isSuccess()) {
+            correctMethods.insert(part.begin(), part.end());
+        } else {
+            collectCorrectMethods(kleePrinter, tests, part, partErrors, includeFlags,
+                                  correctMethods);
+        }
+    }
+}
+
+std::unordered_set<std::string>
+KleeGenerator::findCorrectMethods(printer::KleePrinter &kleePrinter,
+                                  const tests::Tests &tests,
+                                  const std::vector<std::string> &includeFlags) {
+    std::vector<std::string> methods;
+    for (const auto &[methodName, methodDescription] : tests.methods) {
+        methods.push_back(methodDescription.name);
+    }
+    std::unordered_set<std::string> correctMethods;
+    std::unordered_set<std::string> methodsWithErrors;
+    // the whole file is rebuilt alone to get its diagnostics separately from other files
+    if (buildKleeFileForMethods(kleePrinter, tests, methods, includeFlags,
+                                methodsWithErrors).isSuccess()) {
+        correctMethods.insert(methods.begin(), methods.end());
+        return correctMethods;
+    }
+    collectCorrectMethods(kleePrinter, tests, methods, methodsWithErrors, includeFlags,
+                          correctMethods);
+    return correctMethods;
+}
+
 void KleeGenerator::parseKTestsToFinalCode(
         tests::Tests &tests,
         const std::unordered_map<std::string, types::Type> &methodNameToReturnTypeMap,
@@ -21,6 +21,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <unordered_set>
 
 
 using json = nlohmann::json;
@@ -143,6 +144,16 @@ public:
     getCompileCommandsForKlee(const CollectionUtils::MapFileTo<fs::path> &filesToBuild,
                               const CollectionUtils::FileSet &stubSources) const;
 
+    /**
+     * @brief Attributes compilation errors in the klee file to methods by their lines.
+     * @param compilerOutput diagnostics of the compilation of the klee file.
+     * @return methods whose code contains lines of errors.
+     */
+    static std::unordered_set<std::string>
+    getMethodsWithErrors(const std::string &compilerOutput,
+                         const fs::path &kleeFilePath,
+                         const printer::KleePrinter::MethodLineRanges &methodLineRanges);
+
 private:
     BaseTestGen *testGen;
     types::TypesHandler typesHandler;
@@ -156,6 +167,58 @@ private:
             const std::shared_ptr<LineInfo> &lineInfo,
             const std::function<bool(tests::Tests::MethodDescription const &)> &methodFilter =
             [](tests::Tests::MethodDescription const &) { return true; });
+
+    utbot::CompileCommand getDefaultBuildCommand(const fs::path &hintPath,
+                                                 const fs::path &sourceFilePath,
+                                                 const std::vector<std::string> &flags) const;
+
+    /**
+     * @brief Runs given compile commands in a single make invocation with parallel jobs.
+     *
+     * Failure of one command does not stop the others. A single command is compiled
+     * in-process, so its precompiled preamble is reused, unless clang crashes on it.
+     * @return outputs of commands which have been built successfully.
+     */
+    CollectionUtils::FileSet buildInParallel(const std::vector<utbot::CompileCommand> &compileCommands);
+
+    /**
+     * @brief Builds klee file with default compilation flags inside the server process.
+     *
+     * Unlike defaultBuild, reuses the precompiled preamble of the file. Falls back to
+     * defaultBuild if clang crashes.
+     * @return Path to the output file "*.bc" or compiler diagnostics.
+     */
+    Result<fs::path> inProcessBuild(const fs::path &hintPath,
+                                    const fs::path &sourceFilePath,
+                                    const std::vector<std::string> &flags);
+
+    /**
+     * @brief Finds methods whose klee wrappers can be compiled together.
+     *
+     * Methods are first excluded by locations of compilation errors in the generated file. If
+     * errors can't be attributed to methods, the set of methods is bisected, so a file with a
+     * few broken methods costs a logarithmic number of compilations.
+     */
+    std::unordered_set<std::string> findCorrectMethods(printer::KleePrinter &kleePrinter,
+                                                       const tests::Tests &tests,
+                                                       const std::vector<std::string> &includeFlags);
+
+    /**
+     * @param methods methods which break compilation together.
+     * @param methodsWithErrors methods which diagnostics of that compilation point to.
+     */
+    void collectCorrectMethods(printer::KleePrinter &kleePrinter,
+                               const tests::Tests &tests,
+                               const std::vector<std::string> &methods,
+                               const std::unordered_set<std::string> &methodsWithErrors,
+                               const std::vector<std::string> &includeFlags,
+                               std::unordered_set<std::string> &correctMethods);
+
+    Result<fs::path> buildKleeFileForMethods(printer::KleePrinter &kleePrinter,
+                                             const tests::Tests &tests,
+                                             const std::vector<std::string> &methods,
+                                             const std::vector<std::string> &includeFlags,
+                                             std::unordered_set<std::string> &methodsWithErrors);
 };
 
 
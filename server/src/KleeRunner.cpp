@@ -1,10 +1,13 @@
 #include "KleeRunner.h"
 
 #include "Paths.h"
+#include "RequestEnvironment.h"
 #include "TimeExecStatistics.h"
 #include "SARIFGenerator.h"
 #include "exceptions/FileNotPresentedInArtifactException.h"
 #include "exceptions/FileNotPresentedInCommandsException.h"
+#include "tasks/JobScheduler.h"
+#include "tasks/KleeWorkerPool.h"
 #include "tasks/RunKleeTask.h"
 #include "utils/ExecUtils.h"
 #include "utils/FileSystemUtils.h"
@@ -15,7 +18,12 @@
 
 #include "loguru.h"
 
+#include <algorithm>
 #include <fstream>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 #include <utility>
 
 using namespace tests;
@@ -39,6 +47,161 @@ namespace {
         std::stringstream ss(out);
         return StatsUtils::KleeStats(ss);
     }
+
+    const std::string SEEDS_SIGNATURE_FILE_NAME = "signature.txt";
+    const std::string RESULTS_KEY_FILE_NAME = "fingerprint.txt";
+    const std::string EXPLORATION_COMPLETED_FILE_NAME = "completed";
+
+    std::string methodSignature(const Tests &tests, const TestMethod &method) {
+        if (!CollectionUtils::containsKey(tests.methods, method.methodName)) {
+            return "";
+        }
+        const auto &methodDescription = tests.methods.at(method.methodName);
+        auto paramTypes = CollectionUtils::transform(
+            methodDescription.getParamTypes(),
+            [](const types::Type &type) { return type.typeName(); });
+        return StringUtils::stringFormat("%s %s(%s)%s", methodDescription.returnType.typeName(),
+                                         method.methodName, StringUtils::joinWith(paramTypes, ", "),
+                                         method.is32bits ? " -m32" : "");
+    }
+
+    /**
+     * Results of the previous run are reused as is only if KLEE would explore the same IR
+     * with the same settings.
+     */
+    std::string resultsKey(const Tests &tests,
+                           const TestMethod &method,
+                           const utbot::SettingsContext &settingsContext) {
+        if (!CollectionUtils::containsKey(tests.methods, method.methodName)) {
+            return "";
+        }
+        const std::string &fingerprint = tests.methods.at(method.methodName).irFingerprint;
+        if (fingerprint.empty()) {
+            return "";
+        }
+        long timeout = settingsContext.timeoutPerFunction.has_value()
+                           ? settingsContext.timeoutPerFunction->count()
+                           : 0;
+        return StringUtils::stringFormat(
+            "%s timeout=%ld deterministic=%d portfolio=%zu", fingerprint, timeout,
+            settingsContext.useDeterministicSearcher,
+            KleeUtils::searcherPortfolio(settingsContext.useDeterministicSearcher).size());
+    }
+
+    bool fileContentEquals(const fs::path &file, const std::string &expected) {
+        if (expected.empty() || !fs::exists(file)) {
+            return false;
+        }
+        std::ifstream stream(file);
+        std::string content((std::istreambuf_iterator<char>(stream)),
+                            std::istreambuf_iterator<char>());
+        return content == expected;
+    }
+
+    std::vector<fs::path> getArchivedRuns(const fs::path &seedsDir) {
+        std::vector<fs::path> runs;
+        if (!fs::exists(seedsDir)) {
+            return runs;
+        }
+        for (auto const &entry : fs::directory_iterator(seedsDir)) {
+            if (fs::is_directory(entry.path())) {
+                runs.push_back(entry.path());
+            }
+        }
+        std::sort(runs.begin(), runs.end());
+        return runs;
+    }
+
+    /**
+     * Archives ktests of the method, so that they are either reused as is or fed back to KLEE
+     * as seeds by the next run. Seeds are used only while the signature of the function stays
+     * the same, otherwise the layout of symbolic objects in old ktests does not match the new
+     * entrypoint.
+     */
+    void archiveSeeds(const utbot::ProjectContext &projectContext,
+                      const utbot::SettingsContext &settingsContext,
+                      const Tests &tests,
+                      const TestMethod &method,
+                      const std::vector<fs::path> &kleeOuts,
+                      bool explorationCompleted = false) {
+        std::vector<std::vector<fs::path>> runFiles;
+        bool hasKtests = false;
+        for (const fs::path &kleeOut : kleeOuts) {
+            auto &files = runFiles.emplace_back();
+            if (!fs::exists(kleeOut)) {
+                continue;
+            }
+            for (auto const &entry : fs::directory_iterator(kleeOut)) {
+                // all the files KLEE writes for a test case are named testXXXXXX.*
+                if (StringUtils::startsWith(entry.path().filename().string(), "test")) {
+                    files.push_back(entry.path());
+                    hasKtests |= Paths::isKtest(entry.path()) || Paths::isKtestJson(entry.path());
+                }
+            }
+        }
+        if (!hasKtests) {
+            // previous seeds are still better than nothing
+            return;
+        }
+        fs::path seedsDir =
+            Paths::kleeSeedsDirForMethod(projectContext, tests.sourceFilePath, method.methodName);
+        if (fs::exists(seedsDir)) {
+            FileSystemUtils::removeAll(seedsDir);
+        }
+        for (size_t i = 0; i < runFiles.size(); ++i) {
+            fs::path runDir = seedsDir / ("run" + std::to_string(i));
+            fs::create_directories(runDir);
+            for (const fs::path &file : runFiles[i]) {
+                FileSystemUtils::copyFile(file, runDir / file.filename());
+            }
+        }
+        FileSystemUtils::writeToFile(seedsDir / SEEDS_SIGNATURE_FILE_NAME,
+                                     methodSignature(tests, method));
+        FileSystemUtils::writeToFile(seedsDir / RESULTS_KEY_FILE_NAME,
+                                     resultsKey(tests, method, settingsContext));
+        if (explorationCompleted) {
+            FileSystemUtils::writeToFile(seedsDir / EXPLORATION_COMPLETED_FILE_NAME, "");
+        }
+        LOG_S(DEBUG) << "Archived KLEE results for " << method.methodName;
+    }
+
+    /**
+     * @return directories with archived ktests of the method if its IR fingerprint has not
+     * changed since they were produced, and whether that run has completed exploration.
+     */
+    std::optional<std::pair<std::vector<fs::path>, bool>>
+    getReusableResults(const utbot::ProjectContext &projectContext,
+                       const utbot::SettingsContext &settingsContext,
+                       const Tests &tests,
+                       const TestMethod &method) {
+        fs::path seedsDir =
+            Paths::kleeSeedsDirForMethod(projectContext, tests.sourceFilePath, method.methodName);
+        if (!fileContentEquals(seedsDir / RESULTS_KEY_FILE_NAME,
+                               resultsKey(tests, method, settingsContext))) {
+            return std::nullopt;
+        }
+        LOG_S(DEBUG) << "IR of " << method.methodName << " is unchanged, reusing previous ktests";
+        return std::make_pair(getArchivedRuns(seedsDir),
+                              fs::exists(seedsDir / EXPLORATION_COMPLETED_FILE_NAME));
+    }
+
+    struct FileKleeResults {
+        bool processed = false;
+        std::vector<MethodKtests> ktests;
+        StatsUtils::KleeStats kleeStats;
+    };
+}
+
+std::string KleeRunner::ktestInputKey(const std::vector<UTBotKTestObject> &objects) {
+    std::string key;
+    for (const auto &object : objects) {
+        key += object.name;
+        key += '\0';
+        key += std::to_string(object.bytes.size());
+        key += ':';
+        key.append(object.bytes.begin(), object.bytes.end());
+    }
+    return key;
 }
 
 KleeRunner::KleeRunner(utbot::ProjectContext projectContext,
@@ -57,6 +220,7 @@ void KleeRunner::runKlee(const std::vector<tests::TestMethod> &testMethods,
                          StatsUtils::TestsGenerationStatsFileMap &generationStats) {
     LOG_SCOPE_FUNCTION(DEBUG);
 
+    // ktests of previous runs survive in Paths::getKleeSeedsDir and are used as seeds
     fs::path kleeOutDir = Paths::getKleeOutDir(projectContext);
     if (fs::exists(kleeOutDir)) {
         FileSystemUtils::removeAll(kleeOutDir);
@@ -69,13 +233,24 @@ void KleeRunner::runKlee(const std::vector<tests::TestMethod> &testMethods,
 
     nlohmann::json sarifResults = nlohmann::json::array();
 
-    std::function<void(tests::Tests &tests)> prepareTests = [&](tests::Tests &tests) {
+    std::vector<tests::Tests *> files;
+    std::unordered_map<const tests::Tests *, size_t> fileIndices;
+    for (auto it = testsMap.begin(); it != testsMap.end(); ++it) {
+        fileIndices.emplace(&it.value(), files.size());
+        files.push_back(&it.value());
+    }
+
+    // KLEE runs of different files are independent, so they go ahead on worker threads,
+    // while ktests are parsed and printed on this thread in the order of testsMap:
+    // types handler of the generator isn't thread-safe and the output has to be stable.
+    auto runFile = [&](size_t index) {
+        tests::Tests &tests = *files[index];
         fs::path filePath = tests.sourceFilePath;
-        const auto &batch = fileToMethods[filePath];
+        FileKleeResults results;
         if (!tests.isFilePresentedInCommands) {
             if (isBatched) {
                 LOG_S(WARNING) << FileNotPresentedInCommandsException::createMessage(filePath);
-                return;
+                return results;
             } else {
                 throw FileNotPresentedInCommandsException(filePath);
             }
@@ -83,13 +258,15 @@ void KleeRunner::runKlee(const std::vector<tests::TestMethod> &testMethods,
         if (!tests.isFilePresentedInArtifact) {
             if (isBatched) {
                 LOG_S(WARNING) << FileNotPresentedInArtifactException::createMessage(filePath);
-                return;
+                return results;
             } else {
                 throw FileNotPresentedInArtifactException(filePath);
             }
         }
-        std::vector<MethodKtests> ktests;
-        ktests.reserve(batch.size());
+        auto batchIt = fileToMethods.find(filePath);
+        const std::vector<TestMethod> batch =
+            batchIt != fileToMethods.end() ? batchIt->second : std::vector<TestMethod>{};
+        results.ktests.reserve(batch.size());
         std::stringstream logStream;
         if (LogUtils::isMaxVerbosity()) {
             logStream << "Processing batch: ";
@@ -99,14 +276,30 @@ void KleeRunner::runKlee(const std::vector<tests::TestMethod> &testMethods,
             LOG_S(MAX) << logStream.str();
         }
         if (interactiveMode) {
-            processBatchWithInteractive(batch, tests, ktests);
+            processBatchWithInteractive(batch, tests, results.ktests);
         } else {
-            processBatchWithoutInteractive(batch, tests, ktests);
+            processBatchWithoutInteractive(batch, tests, results.ktests);
+        }
+        fs::path kleeOutForFile = Paths::kleeOutDirForFilePath(projectContext, filePath);
+        // KLEE didn't run for a file whose ktests are all reused, there are no stats to read
+        if (fs::exists(kleeOutForFile)) {
+            results.kleeStats = writeKleeStats(kleeOutForFile);
+        }
+        results.processed = true;
+        return results;
+    };
+    size_t threadsCount = std::max(std::thread::hardware_concurrency(), 1u);
+    ExecUtils::OrderedPipeline<FileKleeResults> pipeline(files.size(), threadsCount,
+                                                         2 * threadsCount, runFile);
+
+    std::function<void(tests::Tests &tests)> prepareTests = [&](tests::Tests &tests) {
+        FileKleeResults results = pipeline.take(fileIndices.at(&tests));
+        if (!results.processed) {
+            return;
         }
-        auto kleeStats = writeKleeStats(Paths::kleeOutDirForFilePath(projectContext, filePath));
-        generator->parseKTestsToFinalCode(tests, methodNameToReturnTypeMap, ktests, lineInfo,
-                                          settingsContext.verbose);
-        generationStats.addFileStats(kleeStats, tests);
+        generator->parseKTestsToFinalCode(tests, methodNameToReturnTypeMap, results.ktests,
+                                          lineInfo, settingsContext.verbose);
+        generationStats.addFileStats(results.kleeStats, tests);
 
         sarif::sarifAddTestsToResults(projectContext, tests, sarifResults);
     };
@@ -125,65 +318,77 @@ void KleeRunner::runKlee(const std::vector<tests::TestMethod> &testMethods,
         std::move(prepareTotal));
 }
 
-static void processMethod(MethodKtests &ktestChunk,
-                          tests::Tests &tests,
-                          const fs::path &kleeOut,
-                          const tests::TestMethod &method) {
-    if (!fs::exists(kleeOut)) {
-        return;
-    }
-
-    clearUnusedData(kleeOut);
+void KleeRunner::processMethod(MethodKtests &ktestChunk,
+                               tests::Tests &tests,
+                               const std::vector<fs::path> &kleeOuts,
+                               const tests::TestMethod &method,
+                               bool explorationCompleted) {
     bool hasTimeout = false;
     bool hasError = false;
-    for (auto const &entry : fs::directory_iterator(kleeOut)) {
-        auto const &path = entry.path();
-        if (Paths::isKtestJson(path)) {
-            if (Paths::hasEarly(path)) {
-                hasTimeout = true;
-            } else if (Paths::hasInternalError(path)) {
-                hasError = true;
-            } else {
-                std::unique_ptr<TestCase, decltype(&TestCase_free)> ktestData{
-                    TC_fromFile(path.c_str()), TestCase_free
-                };
-                if (ktestData == nullptr) {
-                    LOG_S(WARNING) << "Unable to open .ktestjson file";
-                    continue;
+    std::unordered_set<std::string> seenInputs;
+    bool anyKleeOut = false;
+    for (const fs::path &kleeOut : kleeOuts) {
+        if (!fs::exists(kleeOut)) {
+            continue;
+        }
+        anyKleeOut = true;
+
+        clearUnusedData(kleeOut);
+        for (auto const &entry : fs::directory_iterator(kleeOut)) {
+            auto const &path = entry.path();
+            if (Paths::isKtestJson(path)) {
+                if (Paths::hasEarly(path)) {
+                    hasTimeout = true;
+                } else if (Paths::hasInternalError(path)) {
+                    hasError = true;
+                } else {
+                    std::unique_ptr<TestCase, decltype(&TestCase_free)> ktestData{
+                        TC_fromFile(path.c_str()), TestCase_free
+                    };
+                    if (ktestData == nullptr) {
+                        LOG_S(WARNING) << "Unable to open .ktestjson file";
+                        continue;
+                    }
+                    const std::vector<fs::path> &errorDescriptorFiles =
+                            Paths::getErrorDescriptors(path);
+
+                    UTBotKTest::Status status = errorDescriptorFiles.empty()
+                                                ? UTBotKTest::Status::SUCCESS
+                                                : UTBotKTest::Status::FAILED;
+                    std::vector<ConcretizedObject> kTestObjects(
+                        ktestData->objects, ktestData->objects + ktestData->n_objects);
+
+                    std::vector<UTBotKTestObject> objects = CollectionUtils::transform(
+                        kTestObjects, [](const ConcretizedObject &kTestObject) {
+                            return UTBotKTestObject{ kTestObject };
+                        });
+                    if (!seenInputs.insert(ktestInputKey(objects)).second) {
+                        continue;
+                    }
+
+                    std::vector<std::string> errorDescriptors = CollectionUtils::transform(
+                        errorDescriptorFiles, [](const fs::path &errorFile) {
+                            std::ifstream fileWithError(errorFile.c_str(), std::ios_base::in);
+                            std::string content((std::istreambuf_iterator<char>(fileWithError)),
+                                                std::istreambuf_iterator<char>());
+
+                            const std::string &errorId = errorFile.stem().extension().string();
+                            if (!errorId.empty()) {
+                                // skip leading dot
+                                content += "\n" + sarif::ERROR_ID_KEY + ":" + errorId.substr(1);
+                            }
+                            return content;
+                        });
+
+                    ktestChunk[method].emplace_back(objects, status, errorDescriptors);
                 }
-                const std::vector<fs::path> &errorDescriptorFiles =
-                        Paths::getErrorDescriptors(path);
-
-                UTBotKTest::Status status = errorDescriptorFiles.empty()
-                                            ? UTBotKTest::Status::SUCCESS
-                                            : UTBotKTest::Status::FAILED;
-                std::vector<ConcretizedObject> kTestObjects(
-                    ktestData->objects, ktestData->objects + ktestData->n_objects);
-
-                std::vector<UTBotKTestObject> objects = CollectionUtils::transform(
-                    kTestObjects, [](const ConcretizedObject &kTestObject) {
-                        return UTBotKTestObject{ kTestObject };
-                    });
-
-                std::vector<std::string> errorDescriptors = CollectionUtils::transform(
-                    errorDescriptorFiles, [](const fs::path &errorFile) {
-                        std::ifstream fileWithError(errorFile.c_str(), std::ios_base::in);
-                        std::string content((std::istreambuf_iterator<char>(fileWithError)),
-                                            std::istreambuf_iterator<char>());
-
-                        const std::string &errorId = errorFile.stem().extension().string();
-                        if (!errorId.empty()) {
-                            // skip leading dot
-                            content += "\n" + sarif::ERROR_ID_KEY + ":" + errorId.substr(1);
-                        }
-                        return content;
-                    });
-
-                ktestChunk[method].emplace_back(objects, status, errorDescriptors);
             }
         }
     }
-    if (hasTimeout) {
+    if (!anyKleeOut) {
+        return;
+    }
+    if (hasTimeout && !explorationCompleted) {
         std::string message = StringUtils::stringFormat(
             "Some tests for function '%s' were skipped, as execution of function is "
             "out of timeout.",
@@ -208,10 +413,15 @@ static void processMethod(MethodKtests &ktestChunk,
 std::pair<std::vector<std::string>, fs::path>
 KleeRunner::createKleeParams(const tests::TestMethod &testMethod,
                              const tests::Tests &tests,
-                             const std::string &methodNameOrEmptyForFolder) {
+                             const std::string &methodNameOrEmptyForFolder,
+                             const KleeUtils::SearcherConfig &searcher,
+                             bool isPortfolioMember) {
     fs::path kleeOut = Paths::kleeOutDirForEntrypoints(projectContext,
                                                        tests.sourceFilePath,
                                                        methodNameOrEmptyForFolder);
+    if (isPortfolioMember) {
+        kleeOut = Paths::addSuffix(kleeOut, "_" + searcher.name);
+    }
     fs::create_directories(kleeOut.parent_path());
 
     std::vector<std::string> argvData = { "klee",
@@ -232,8 +442,21 @@ KleeRunner::createKleeParams(const tests::TestMethod &testMethod,
                                           "--check-overshift=false",
                                           "--skip-not-lazy-and-symbolic-pointers",
                                           "--output-dir=" + kleeOut.string()};
-    if (settingsContext.useDeterministicSearcher) {
-        argvData.emplace_back("--search=dfs");
+    CollectionUtils::extend(argvData, searcher.flags);
+    if (!methodNameOrEmptyForFolder.empty()) {
+        fs::path seedsDir = Paths::kleeSeedsDirForMethod(projectContext, tests.sourceFilePath,
+                                                         testMethod.methodName);
+        if (fileContentEquals(seedsDir / SEEDS_SIGNATURE_FILE_NAME,
+                              methodSignature(tests, testMethod))) {
+            std::vector<fs::path> runDirs = getArchivedRuns(seedsDir);
+            for (const fs::path &runDir : runDirs) {
+                argvData.emplace_back("--seed-dir=" + runDir.string());
+            }
+            if (!runDirs.empty()) {
+                argvData.emplace_back("--allow-seed-extension");
+                argvData.emplace_back("--allow-seed-truncation");
+            }
+        }
     }
     if (testMethod.is32bits) {
         // 32bit project
@@ -257,6 +480,7 @@ void KleeRunner::processBatchWithoutInteractive(const std::vector<tests::TestMet
         return;
     }
 
+    auto portfolio = KleeUtils::searcherPortfolio(settingsContext.useDeterministicSearcher);
     for (const auto &testMethod : testMethods) {
         if (testMethod.sourceFilePath != tests.sourceFilePath) {
             std::string message = StringUtils::stringFormat(
@@ -266,7 +490,28 @@ void KleeRunner::processBatchWithoutInteractive(const std::vector<tests::TestMet
             LOG_S(WARNING) << message;
         }
 
-        auto [argvData, kleeOut] = createKleeParams(testMethod, tests, testMethod.methodName);
+        if (auto reusable = getReusableResults(projectContext, settingsContext, tests, testMethod)) {
+            MethodKtests ktestChunk;
+            processMethod(ktestChunk, tests, reusable->first, testMethod, reusable->second);
+            ktests.push_back(ktestChunk);
+            continue;
+        }
+
+        if (portfolio.size() > 1) {
+            MEASURE_FUNCTION_EXECUTION_TIME
+            auto [kleeOuts, explorationCompleted] =
+                runSearcherPortfolio(testMethod, tests, portfolio);
+            ExecUtils::throwIfCancelled();
+
+            MethodKtests ktestChunk;
+            processMethod(ktestChunk, tests, kleeOuts, testMethod, explorationCompleted);
+            archiveSeeds(projectContext, settingsContext, tests, testMethod, kleeOuts,
+                         explorationCompleted);
+            ktests.push_back(ktestChunk);
+            continue;
+        }
+
+        auto [argvData, kleeOut] = createKleeParams(testMethod, tests, testMethod.methodName, portfolio[0]);
         addTailKleeInitParams(argvData, testMethod.bitcodeFilePath);
         {
             std::vector<char *> cargv, cenvp;
@@ -275,17 +520,129 @@ void KleeRunner::processBatchWithoutInteractive(const std::vector<tests::TestMet
             LOG_S(DEBUG) << "Klee command :: " + StringUtils::joinWith(argvData, " ");
             MEASURE_FUNCTION_EXECUTION_TIME
 
-            RunKleeTask task(cargv.size(), cargv.data(), settingsContext.timeoutPerFunction);
-            ExecUtils::ExecutionResult result __attribute__((unused)) = task.run();
+            std::optional<ExecUtils::ExecutionResult> remoteResult;
+            if (KleeWorkerPool::getInstance().isEnabled()) {
+                remoteResult = KleeWorkerPool::getInstance().run(
+                    argvData, testMethod.bitcodeFilePath, kleeOut,
+                    settingsContext.timeoutPerFunction);
+            }
+            if (!remoteResult.has_value()) {
+                RunKleeTask task(cargv.size(), cargv.data(), settingsContext.timeoutPerFunction);
+                task.setLogFilePath(
+                    Paths::getKleeTmpLogFilePath(projectContext, tests.sourceFilePath));
+                ExecUtils::ExecutionResult result __attribute__((unused)) = task.run();
+            }
             ExecUtils::throwIfCancelled();
 
             MethodKtests ktestChunk;
-            processMethod(ktestChunk, tests, kleeOut, testMethod);
+            processMethod(ktestChunk, tests, { kleeOut }, testMethod);
+            archiveSeeds(projectContext, settingsContext, tests, testMethod, { kleeOut });
             ktests.push_back(ktestChunk);
         }
     }
 }
 
+std::pair<std::vector<fs::path>, bool>
+KleeRunner::runSearcherPortfolio(const tests::TestMethod &testMethod,
+                                 const tests::Tests &tests,
+                                 const std::vector<KleeUtils::SearcherConfig> &portfolio) {
+    LOG_S(DEBUG) << "Running portfolio of " << portfolio.size() << " KLEE searchers for "
+                 << testMethod.methodName;
+    // worker threads have to observe cancellation and log to the same client
+    const std::optional<std::string> clientId = RequestEnvironment::clientId;
+    grpc::ServerContext *const serverContext = RequestEnvironment::serverContext;
+    const RequestEnvironment::Priority priority = RequestEnvironment::getPriority();
+    const auto trace = TimeExecStatistics::getTrace();
+    // The first run goes in the slot this thread holds. The others can't wait for slots while
+    // it is held, so they run only in slots which are free right now, not to exceed
+    // --max-jobs.
+    const bool holdsSlot = JobScheduler::holdsSlot();
+    std::atomic_bool stopFlag = false;
+    std::optional<size_t> completedRun;
+    std::mutex completedRunMutex;
+
+    std::vector<fs::path> kleeOuts;
+    std::vector<std::future<void>> runs;
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        auto [argvData, kleeOut] =
+            createKleeParams(testMethod, tests, testMethod.methodName, portfolio[i], true);
+        addTailKleeInitParams(argvData, testMethod.bitcodeFilePath);
+        kleeOuts.push_back(kleeOut);
+        runs.push_back(std::async(std::launch::async, [&, i, argvData = std::move(argvData),
+                                                       kleeOut = kleeOut]() mutable {
+            if (clientId.has_value()) {
+                RequestEnvironment::setClientId(clientId.value());
+                loguru::set_thread_name(clientId->c_str());
+            }
+            RequestEnvironment::setServerContext(serverContext);
+            RequestEnvironment::setPriority(priority);
+            TimeExecStatistics::setTrace(trace);
+            JobScheduler::InheritedSlot inheritedSlot(holdsSlot && i == 0);
+            std::optional<JobScheduler::Slot> slot;
+            if (holdsSlot && i > 0) {
+                slot = JobScheduler::getInstance().tryAcquire();
+                if (!slot.has_value()) {
+                    LOG_S(DEBUG) << "No free job slot for KLEE searcher '" << portfolio[i].name
+                                 << "' of " << testMethod.methodName << ", skipping it";
+                    return;
+                }
+            }
+
+            std::vector<char *> cargv, cenvp;
+            std::vector<std::string> tmp;
+            ExecUtils::toCArgumentsPtr(argvData, tmp, cargv, cenvp, false);
+            LOG_S(DEBUG) << "Klee command :: " + StringUtils::joinWith(argvData, " ");
+
+            auto start = std::chrono::steady_clock::now();
+            ExecUtils::ExecutionResult result{};
+            try {
+                std::optional<ExecUtils::ExecutionResult> remoteResult;
+                if (KleeWorkerPool::getInstance().isEnabled()) {
+                    remoteResult = KleeWorkerPool::getInstance().run(
+                        argvData, testMethod.bitcodeFilePath, kleeOut,
+                        settingsContext.timeoutPerFunction, &stopFlag);
+                }
+                if (remoteResult.has_value()) {
+                    result = remoteResult.value();
+                } else {
+                    RunKleeTask task(cargv.size(), cargv.data(), settingsContext.timeoutPerFunction);
+                    task.setLogFilePath(Paths::addSuffix(
+                        Paths::getKleeTmpLogFilePath(projectContext, tests.sourceFilePath),
+                        "_" + portfolio[i].name));
+                    task.addStopFlag(&stopFlag);
+                    result = task.run();
+                }
+            } catch (...) {
+                stopFlag = true;
+                throw;
+            }
+            bool inTime = !settingsContext.timeoutPerFunction.has_value() ||
+                          std::chrono::steady_clock::now() - start <
+                              settingsContext.timeoutPerFunction.value();
+            // A run that stops on its own has either covered everything or exhausted its
+            // paths, so there is nothing left for the rest of the portfolio to find.
+            if (result.status == 0 && inTime && !stopFlag.exchange(true)) {
+                std::lock_guard<std::mutex> guard(completedRunMutex);
+                completedRun = i;
+                LOG_S(DEBUG) << "KLEE searcher '" << portfolio[i].name
+                             << "' completed exploration of " << testMethod.methodName
+                             << ", stopping the rest of portfolio";
+            }
+        }));
+    }
+    for (auto &run : runs) {
+        run.wait();
+    }
+    for (auto &run : runs) {
+        run.get();
+    }
+    if (!completedRun.has_value()) {
+        return { kleeOuts, false };
+    }
+    std::swap(kleeOuts[0], kleeOuts[completedRun.value()]);
+    return { kleeOuts, true };
+}
+
 void KleeRunner::processBatchWithInteractive(const std::vector<tests::TestMethod> &testMethods,
                                              tests::Tests &tests,
                                              std::vector<tests::MethodKtests> &ktests) {
@@ -293,6 +650,13 @@ void KleeRunner::processBatchWithInteractive(const std::vector<tests::TestMethod
         return;
     }
 
+    // a single interactive KLEE process can't be split between workers, methods of the
+    // batch are run one by one instead, so that each of them may go to a worker
+    if (KleeWorkerPool::getInstance().isEnabled()) {
+        processBatchWithoutInteractive(testMethods, tests, ktests);
+        return;
+    }
+
     for (const auto &method : testMethods) {
         if (method.sourceFilePath != tests.sourceFilePath) {
             std::string message = StringUtils::stringFormat(
@@ -303,7 +667,26 @@ void KleeRunner::processBatchWithInteractive(const std::vector<tests::TestMethod
         }
     }
 
-    auto [argvData, kleeOut] = createKleeParams(testMethods[0], tests, "");
+    std::unordered_map<std::string, MethodKtests> reusedKtests;
+    std::vector<TestMethod> methodsToRun;
+    for (const auto &method : testMethods) {
+        if (auto reusable = getReusableResults(projectContext, settingsContext, tests, method)) {
+            processMethod(reusedKtests[method.methodName], tests, reusable->first, method,
+                          reusable->second);
+        } else {
+            methodsToRun.push_back(method);
+        }
+    }
+    if (methodsToRun.empty()) {
+        for (const auto &method : testMethods) {
+            ktests.push_back(reusedKtests[method.methodName]);
+        }
+        return;
+    }
+
+    auto [argvData, kleeOut] = createKleeParams(
+        methodsToRun[0], tests, "",
+        KleeUtils::searcherPortfolio(settingsContext.useDeterministicSearcher).front());
     {
         // additional KLEE arguments
         argvData.emplace_back("--interactive");
@@ -312,7 +695,7 @@ void KleeRunner::processBatchWithInteractive(const std::vector<tests::TestMethod
             // entrypoints
             fs::path entrypoints = kleeOut.parent_path() / "entrypoints.txt";
             std::ofstream of(entrypoints);
-            for (const auto &method : testMethods) {
+            for (const auto &method : methodsToRun) {
                 of << KleeUtils::entryPointFunction(tests, method.methodName, true) << std::endl;
             }
             argvData.emplace_back("--entrypoints-file=" + entrypoints.string());
@@ -321,7 +704,7 @@ void KleeRunner::processBatchWithInteractive(const std::vector<tests::TestMethod
             argvData.emplace_back(StringUtils::stringFormat(
                 "--timeout-per-function=%d", settingsContext.timeoutPerFunction.value()));
         }
-        addTailKleeInitParams(argvData, testMethods[0].bitcodeFilePath);
+        addTailKleeInitParams(argvData, methodsToRun[0].bitcodeFilePath);
     }
     {
         std::vector<char *> cargv, cenvp;
@@ -334,18 +717,24 @@ void KleeRunner::processBatchWithInteractive(const std::vector<tests::TestMethod
         RunKleeTask task(cargv.size(),
                          cargv.data(),
                          settingsContext.timeoutPerFunction.has_value()
-                             ? settingsContext.timeoutPerFunction.value() * testMethods.size()
+                             ? settingsContext.timeoutPerFunction.value() * methodsToRun.size()
                              : settingsContext.timeoutPerFunction);
+        task.setLogFilePath(Paths::getKleeTmpLogFilePath(projectContext, tests.sourceFilePath));
         ExecUtils::ExecutionResult result __attribute__((unused)) = task.run();
 
         ExecUtils::throwIfCancelled();
 
         for (const auto &method : testMethods) {
+            if (CollectionUtils::containsKey(reusedKtests, method.methodName)) {
+                ktests.push_back(reusedKtests[method.methodName]);
+                continue;
+            }
             std::string kleeMethodName =
                 KleeUtils::entryPointFunction(tests, method.methodName, true);
             fs::path newKleeOut = kleeOut / kleeMethodName;
             MethodKtests ktestChunk;
-            processMethod(ktestChunk, tests, newKleeOut, method);
+            processMethod(ktestChunk, tests, { newKleeOut }, method);
+            archiveSeeds(projectContext, settingsContext, tests, method, { newKleeOut });
             ktests.push_back(ktestChunk);
         }
     }
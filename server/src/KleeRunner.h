@@ -6,6 +6,7 @@
 #include "SettingsContext.h"
 #include "Tests.h"
 #include "streams/tests/TestsWriter.h"
+#include "utils/KleeUtils.h"
 #include "utils/stats/KleeStats.h"
 #include "utils/stats/TestsGenerationStats.h"
 
@@ -22,6 +23,8 @@ public:
      *
      * Run Klee for test generation.
      * Pass no more than `batchSize` methods to the scrypt simultaneously.
+     * Source files are run by KLEE in parallel, their tests are printed and written in the
+     * order of `testsMap`, see ExecUtils::OrderedPipeline.
      * @param testMethods Vector of names of testing source methods and linked bitcode files where
      * they defined.
      * @return Vector of KTestObject chunks. Each chunk contains data of
@@ -35,6 +38,24 @@ public:
                  bool interactiveMode,
                  StatsUtils::TestsGenerationStatsFileMap &generationStats);
 
+    /**
+     * Collects ktests of the method from the given KLEE output directories. Directories are
+     * produced by different runs of the same entrypoint, so inputs found by several runs are
+     * taken only once. If one of the runs has completed exploration, early terminated states
+     * of the others are not reported as a timeout.
+     */
+    static void processMethod(tests::MethodKtests &ktestChunk,
+                              tests::Tests &tests,
+                              const std::vector<fs::path> &kleeOuts,
+                              const tests::TestMethod &method,
+                              bool explorationCompleted = false);
+
+    /**
+     * @return key of the inputs of a ktest: names and bytes of its objects. Addresses are not a
+     * part of it, since different runs allocate the same inputs differently.
+     */
+    static std::string ktestInputKey(const std::vector<tests::UTBotKTestObject> &objects);
+
 private:
     const utbot::ProjectContext projectContext;
     const utbot::SettingsContext settingsContext;
@@ -47,10 +68,25 @@ private:
                                      tests::Tests &tests,
                                      std::vector<tests::MethodKtests> &ktests);
 
+    /**
+     * @brief Runs several KLEE searcher configurations for one method in parallel.
+     *
+     * As soon as one of the runs finishes exploration on its own, the others are stopped
+     * and dump what they have found so far.
+     * @return output directories of all runs of the portfolio, the run which has completed
+     * exploration goes first, and whether there is such a run.
+     */
+    std::pair<std::vector<fs::path>, bool>
+    runSearcherPortfolio(const tests::TestMethod &testMethod,
+                         const tests::Tests &tests,
+                         const std::vector<KleeUtils::SearcherConfig> &portfolio);
+
     std::pair<std::vector<std::string>, fs::path>
     createKleeParams(const tests::TestMethod &testMethod,
                      const tests::Tests &tests,
-                     const std::string &methodNameOrEmptyForFolder);
+                     const std::string &methodNameOrEmptyForFolder,
+                     const KleeUtils::SearcherConfig &searcher,
+                     bool isPortfolioMember = false);
 
     void addTailKleeInitParams(std::vector<std::string> &argvData,
                                const std::string &bitcodeFilePath);
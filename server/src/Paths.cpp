@@ -177,6 +177,13 @@ namespace Paths {
         return kleeOutDirForFile / ("klee_out_" + suffix);
     }
 
+    fs::path kleeSeedsDirForMethod(const utbot::ProjectContext &projectContext,
+                                   const fs::path &srcFilePath,
+                                   const std::string &methodName) {
+        fs::path relative = fs::relative(addOrigExtensionAsSuffixAndAddNew(srcFilePath, ""), projectContext.projectPath);
+        return getKleeSeedsDir(projectContext) / relative / methodName;
+    }
+
     //endregion
 
     //region extensions
@@ -176,6 +176,10 @@ namespace Paths {
         return getBaseLogDir() / RequestEnvironment::getClientId() / projectName;
     }
 
+    static inline fs::path getTracePath(uint64_t requestId) {
+        return getLogDir() / "traces" / ("request_" + std::to_string(requestId) + ".json");
+    }
+
     static inline fs::path getExecLogPath(const std::string &projectName) {
         fs::path execLogPath = getLogDir(projectName);
         auto logFilename = TimeUtils::getDate() + ".log";
@@ -189,6 +193,27 @@ namespace Paths {
 
     //endregion
 
+    /**
+     * Server-wide directory with gtest objects shared by all projects.
+     */
+    static inline fs::path getGtestCacheDir() {
+        return logPath / "gtest_cache";
+    }
+
+    /**
+     * Default directory of ArtifactStore, if `--artifact-store` isn't set.
+     */
+    static inline fs::path getDefaultArtifactStoreDir() {
+        return logPath / "artifact_store";
+    }
+
+    /**
+     * Directory with KLEE outputs of runs requested by other servers, see KleeWorkerPool.
+     */
+    static inline fs::path getKleeWorkerDir() {
+        return logPath / "klee_worker";
+    }
+
     static inline fs::path getUTBotFiles(const utbot::ProjectContext &projectContext) {
         return projectContext.buildDir() / CompilationUtils::UTBOT_FILES_DIR_NAME;
     }
@@ -224,10 +249,39 @@ namespace Paths {
         return getBaseLogDir() / "klee_tmp_log.txt";
     }
 
+    /**
+     * KLEE runs of different source files go in parallel, so each file has its own log.
+     */
+    static inline fs::path getKleeTmpLogFilePath(const utbot::ProjectContext &projectContext,
+                                                 const fs::path &sourceFilePath) {
+        return addSuffix(getKleeTmpLogFilePath(),
+                         "_" + mangle(fs::relative(sourceFilePath, projectContext.projectPath)));
+    }
+
     static inline fs::path getKleeOutDir(const utbot::ProjectContext &projectContext) {
         return getUTBotFiles(projectContext) / "klee_out";
     }
 
+    static inline fs::path getKleeSeedsDir(const utbot::ProjectContext &projectContext) {
+        return getUTBotFiles(projectContext) / "klee_seeds";
+    }
+
+    static inline fs::path getSynchronizationManifestPath(const utbot::ProjectContext &projectContext) {
+        return getUTBotFiles(projectContext) / "synchronization_manifest.json";
+    }
+
+    static inline fs::path getStubsIndexPath(const utbot::ProjectContext &projectContext) {
+        return getUTBotFiles(projectContext) / "stubs_index.json";
+    }
+
+    /**
+     * Instrumented objects of project sources addressed by their preprocessed content and
+     * compilation command. Kept outside of the build directory, so `make clean` keeps it.
+     */
+    static inline fs::path getInstrumentedObjectCacheDir(const utbot::ProjectContext &projectContext) {
+        return getUTBotFiles(projectContext) / "object_cache";
+    }
+
     static inline bool isKtest(fs::path const &path) {
         return path.extension() == ".ktest";
     }
@@ -251,6 +305,10 @@ namespace Paths {
                                       const fs::path &srcFilePath,
                                       const std::string &methodNameOrEmptyForFolder);
 
+    fs::path kleeSeedsDirForMethod(const utbot::ProjectContext &projectContext,
+                                   const fs::path &srcFilePath,
+                                   const std::string &methodName);
+
     //endregion
 
     //region extensions
@@ -3,6 +3,8 @@
 namespace RequestEnvironment {
     thread_local std::optional<std::string> clientId;
     thread_local grpc::ServerContext *serverContext;
+    thread_local Priority priority = Priority::INTERACTIVE;
+    thread_local const ProgressWriter *progressWriter = nullptr;
 
     const std::string &getClientId() {
         if (!clientId.has_value()) {
@@ -27,4 +29,31 @@ namespace RequestEnvironment {
     bool isCancelled() {
         return serverContext && serverContext->IsCancelled();
     }
+
+    Priority getPriority() {
+        return priority;
+    }
+
+    void setPriority(Priority requestPriority) {
+        priority = requestPriority;
+    }
+
+    const ProgressWriter *getProgressWriter() {
+        return progressWriter;
+    }
+
+    void setProgressWriter(const ProgressWriter *requestProgressWriter) {
+        progressWriter = requestProgressWriter;
+    }
+
+    JobContext::JobContext(Priority jobPriority, const ProgressWriter *jobProgressWriter)
+        : previousPriority(priority), previousProgressWriter(progressWriter) {
+        priority = jobPriority;
+        progressWriter = jobProgressWriter;
+    }
+
+    JobContext::~JobContext() {
+        priority = previousPriority;
+        progressWriter = previousProgressWriter;
+    }
 }
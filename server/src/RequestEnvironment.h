@@ -3,15 +3,48 @@
 
 #include <grpcpp/grpcpp.h>
 
+class ProgressWriter;
+
 namespace RequestEnvironment {
+    /**
+     * Interactive requests (line, function, file) are scheduled before batch ones.
+     */
+    enum class Priority { INTERACTIVE, BATCH };
+
     extern thread_local std::optional<std::string> clientId;
     extern thread_local grpc::ServerContext *serverContext;
+    extern thread_local Priority priority;
+    /**
+     * Writer of the request, it is set only for the thread handling the request, since
+     * writers are not thread-safe.
+     */
+    extern thread_local const ProgressWriter *progressWriter;
 
     const std::string &getClientId();
     const grpc::ServerContext *getServerContext();
     void setClientId(std::string requestClientId);
     void setServerContext(grpc::ServerContext *requestServerContext);
     bool isCancelled();
+    Priority getPriority();
+    void setPriority(Priority requestPriority);
+    const ProgressWriter *getProgressWriter();
+    void setProgressWriter(const ProgressWriter *requestProgressWriter);
+
+    /**
+     * Sets priority and progress writer of the current thread and restores previous ones on
+     * destruction, so the writer doesn't outlive the request.
+     */
+    class JobContext {
+    public:
+        JobContext(Priority jobPriority, const ProgressWriter *jobProgressWriter);
+        JobContext(const JobContext &) = delete;
+        JobContext &operator=(const JobContext &) = delete;
+        ~JobContext();
+
+    private:
+        Priority previousPriority;
+        const ProgressWriter *previousProgressWriter;
+    };
 };
 
 
@@ -4,12 +4,14 @@
 #include "FeaturesFilter.h"
 #include "GTestLogger.h"
 #include "KleeRunner.h"
+#include "RequestEnvironment.h"
 #include "ReturnTypesFetcher.h"
 #include "Synchronizer.h"
 #include "Version.h"
 #include "building/Linker.h"
 #include "building/UserProjectConfiguration.h"
 #include "clang-utils/SourceToHeaderRewriter.h"
+#include "commands/Commands.h"
 #include "coverage/CoverageAndResultsGenerator.h"
 #include "exceptions/EnvironmentException.h"
 #include "exceptions/FileNotPresentedInArtifactException.h"
@@ -27,15 +29,21 @@
 #include "stubs/StubGen.h"
 #include "stubs/StubSourcesFinder.h"
 #include "stubs/StubsCollector.h"
+#include "tasks/ArtifactStore.h"
+#include "tasks/RunKleeTask.h"
+#include "utils/ExecUtils.h"
+#include "utils/FileSystemUtils.h"
 #include "utils/LogUtils.h"
 #include "utils/ServerUtils.h"
 #include "utils/stats/TestsGenerationStats.h"
 #include "utils/stats/TestsExecutionStats.h"
 #include "utils/TypeUtils.h"
 #include "building/ProjectBuildDatabase.h"
+#include "building/ProjectSessionCache.h"
 
 #include <thread>
 #include <fstream>
+#include <unistd.h>
 
 using TypeUtils::isSameType;
 
@@ -60,6 +68,11 @@ void Server::run(uint16_t customPort) {
     ServerBuilder builder;
     builder.AddListeningPort(address, grpc::InsecureServerCredentials());
     builder.RegisterService(&testsService);
+    if (Commands::kleeWorker) {
+        // the service runs anything it is sent, so it is available only on request
+        builder.RegisterService(&kleeWorkerService);
+        LOG_S(INFO) << "Serving KLEE runs of other servers";
+    }
     if (ServerUtils::checkPort(host, port)) {
         LOG_S(INFO) << "Address: " << address << std::endl;
         /* Launches the watcher in a separate thread that releases
@@ -84,7 +97,7 @@ uint16_t Server::getPort() {
 Server::Server() {
 }
 
-Server::Server(bool testMode) : testsService(testMode) {
+Server::Server(bool testMode) : testsService(testMode), kleeWorkerService(testMode) {
 }
 
 Server::~Server() {
@@ -179,8 +192,10 @@ Status Server::TestsGenServiceImpl::CreateTestsCoverageAndResult(
     Status status;
     {
         MEASURE_FUNCTION_EXECUTION_TIME
+        RequestEnvironment::JobContext jobContext(RequestEnvironment::Priority::INTERACTIVE,
+                                                  coverageAndResultsWriter.get());
         CoverageAndResultsGenerator coverageGenerator(request, coverageAndResultsWriter.get());
-        TimeExecStatistics::clearStatistic();
+        TimeExecStatistics::RequestScope requestStatistics;
         auto settingsContext = utbot::SettingsContext(request->settingscontext());
         status = coverageGenerator.generate(request->coverage(), settingsContext);
         TimeExecStatistics::printStatistic();
@@ -193,6 +208,10 @@ Status Server::TestsGenServiceImpl::ProcessBaseTestRequest(BaseTestGen &testGen,
                                                            TestsWriter *testsWriter) {
     try {
         MEASURE_FUNCTION_EXECUTION_TIME
+        RequestEnvironment::JobContext jobContext(testGen.isBatched()
+                                                      ? RequestEnvironment::Priority::BATCH
+                                                      : RequestEnvironment::Priority::INTERACTIVE,
+                                                  testGen.progressWriter);
         auto preprocessingStartTime = std::chrono::steady_clock::now();
         types::TypesHandler::SizeContext sizeContext;
 
@@ -340,37 +359,26 @@ std::string extractMessage(const loguru::Message &message) {
 }
 
 void Server::logToClient(void *channel, const loguru::Message &message) {
-    auto data = reinterpret_cast<WriterData *>(channel);
-    if (data == nullptr) {
+    auto logChannel = reinterpret_cast<LogChannel *>(channel);
+    if (logChannel == nullptr) {
         throw BaseException("Couldn't handle logging to client, data is null");
     }
-    std::vector<char> thread_name(LOGURU_BUFFER_SIZE);
-    loguru::get_thread_name(thread_name.data(), LOGURU_BUFFER_SIZE, false);
-
-    if (std::string(thread_name.data()) == data->client &&
-        std::string(message.filename) != std::string(GTestLogger::fileName())) {
-        LogEntry logEntry;
-        std::string extractedMessage = extractMessage(message);
-        logEntry.set_message(extractedMessage);
-        std::lock_guard<std::mutex> guard(data->writerMutex);
-        data->writer->Write(logEntry);
+    const auto &clientId = RequestEnvironment::clientId;
+    if (clientId.has_value() && clientId.value() == logChannel->getClient() &&
+        strcmp(message.filename, GTestLogger::fileName()) != 0) {
+        logChannel->push(extractMessage(message));
     }
 }
 
 void Server::gtestLog(void *channel, const loguru::Message &message) {
-    auto data = reinterpret_cast<WriterData *>(channel);
-    if (data == nullptr) {
+    auto logChannel = reinterpret_cast<LogChannel *>(channel);
+    if (logChannel == nullptr) {
         throw BaseException("Can't interpret gtest log channel");
     }
-    std::vector<char> thread_name(LOGURU_BUFFER_SIZE);
-    loguru::get_thread_name(thread_name.data(), LOGURU_BUFFER_SIZE, false);
-
-    if (std::string(thread_name.data()) == data->client &&
-        std::string(message.filename) == std::string(GTestLogger::fileName())) {
-        LogEntry logEntry;
-        logEntry.set_message(message.message);
-        std::lock_guard<std::mutex> guard(data->writerMutex);
-        data->writer->Write(logEntry);
+    const auto &clientId = RequestEnvironment::clientId;
+    if (clientId.has_value() && clientId.value() == logChannel->getClient() &&
+        strcmp(message.filename, GTestLogger::fileName()) == 0) {
+        logChannel->push(message.message);
     }
 }
 
@@ -394,7 +402,7 @@ Status Server::TestsGenServiceImpl::provideLoggingCallbacks(
     auto oldValue = channelStorage[client].load(std::memory_order_relaxed);
     if (!oldValue && channelStorage[client].compare_exchange_weak(
             oldValue, true, std::memory_order_release, std::memory_order_relaxed)) {
-        WriterData data{writer, std::mutex(), client};
+        auto logChannel = std::make_shared<LogChannel>(client, LogChannel::DEFAULT_CAPACITY);
         fs::path logFilePath = Paths::getLogDir();
         if (!fs::exists(logFilePath)) {
             fs::create_directories(logFilePath);
@@ -402,8 +410,12 @@ Status Server::TestsGenServiceImpl::provideLoggingCallbacks(
         fs::path allLogPath = logFilePath / "everything.log";
         fs::path latestLogPath = logFilePath / "latest_readable.log";
         auto callbackName = callbackPrefix + client;
+        {
+            std::lock_guard<std::mutex> lock(logChannelsMutex);
+            logChannels[callbackName] = logChannel;
+        }
         loguru::set_name_to_verbosity_callback(&::MaxNameToVerbosityCallback);
-        loguru::add_callback(callbackName.c_str(), handler, &data,
+        loguru::add_callback(callbackName.c_str(), handler, logChannel.get(),
                              loguru::get_verbosity_from_name(logLevel.c_str()));
         if (openFiles) {
             loguru::add_file(allLogPath.c_str(), loguru::Append,
@@ -411,24 +423,25 @@ Status Server::TestsGenServiceImpl::provideLoggingCallbacks(
             loguru::add_file(latestLogPath.c_str(), loguru::Truncate,
                              loguru::Verbosity_INFO);
         }
-        holdLockFlag[callbackName] = true;
         /*
-         * We use spinlocks here, because ServerWriter<LogEntry> *writer
-         * is invalidated when Status::OK is sent, and therefore we can
-         * not send logs to clients when they issue requests to UTBot. Possible
-         * ways of redesigning logging system and removing the spinlock are:
-         * 1. Using gRPC async API
-         * 2. Issuing a request from UTBot to a specific client on every log entry.
+         * ServerWriter<LogEntry> *writer is invalidated when Status::OK is sent, so the RPC
+         * thread keeps the stream open and writes messages logged by the client threads
+         * until the channel is closed or the client disconnects.
          */
-        using namespace std::chrono_literals;
-        while (holdLockFlag[callbackName].exchange(true, std::memory_order_acquire)) {
-            std::this_thread::sleep_for(1ms);
-        }
+        logChannel->drainTo(writer);
         loguru::remove_callback(callbackName.c_str());
         if (openFiles) {
             loguru::remove_callback(allLogPath.c_str());
             loguru::remove_callback(latestLogPath.c_str());
         }
+        {
+            std::lock_guard<std::mutex> lock(logChannelsMutex);
+            // the channel may be replaced by a new one of the reconnected client
+            if (auto it = logChannels.find(callbackName);
+                it != logChannels.end() && it->second == logChannel) {
+                logChannels.erase(it);
+            }
+        }
         channelStorage[client] = false;
     }
     return Status::OK;
@@ -446,8 +459,7 @@ Status Server::TestsGenServiceImpl::CloseLogChannel(ServerContext *context,
                                                     const DummyRequest *request,
                                                     DummyResponse *response) {
     ServerUtils::setThreadOptions(context, testMode);
-    const std::string callbackName = logPrefix + RequestEnvironment::getClientId();
-    holdLockFlag[callbackName].store(false, std::memory_order_release);
+    closeLogChannel(logPrefix + RequestEnvironment::getClientId());
     return Status::OK;
 }
 
@@ -463,11 +475,22 @@ Status Server::TestsGenServiceImpl::CloseGTestChannel(ServerContext *context,
                                                       const DummyRequest *request,
                                                       DummyResponse *response) {
     ServerUtils::setThreadOptions(context, testMode);
-    const std::string callbackName = gtestLogPrefix + RequestEnvironment::getClientId();
-    holdLockFlag[callbackName].store(false, std::memory_order_release);
+    closeLogChannel(gtestLogPrefix + RequestEnvironment::getClientId());
     return Status::OK;
 }
 
+void Server::TestsGenServiceImpl::closeLogChannel(const std::string &callbackName) {
+    std::lock_guard<std::mutex> lock(logChannelsMutex);
+    if (auto it = logChannels.find(callbackName); it != logChannels.end()) {
+        it->second->close();
+    }
+}
+
+void Server::TestsGenServiceImpl::closeLogChannels(const std::string &client) {
+    closeLogChannel(logPrefix + client);
+    closeLogChannel(gtestLogPrefix + client);
+}
+
 
 Status Server::TestsGenServiceImpl::Heartbeat(ServerContext *context,
                                               const DummyRequest *request,
@@ -497,7 +520,6 @@ Status Server::TestsGenServiceImpl::GetFunctionReturnType(ServerContext *context
     LOG_S(INFO) << "GetFunctionReturnType receive:\n" << request->DebugString();
 
     ServerUtils::setThreadOptions(context, testMode);
-    auto lock = acquireLock();
 
     MEASURE_FUNCTION_EXECUTION_TIME
 
@@ -539,11 +561,15 @@ Status Server::TestsGenServiceImpl::GenerateProjectStubs(ServerContext *context,
         return ProcessProjectStubsRequest(testGen.get(), stubsWriter.get());
     } catch (const CompilationDatabaseException &e) {
         return failedToLoadCDbStatus(e);
+    } catch (const CancellationException &e) {
+        return Status::CANCELLED;
     }
 }
 
 Status Server::TestsGenServiceImpl::ProcessProjectStubsRequest(BaseTestGen *testGen,
                                                                StubsWriter *stubsWriter) {
+    RequestEnvironment::JobContext jobContext(RequestEnvironment::Priority::BATCH,
+                                              testGen->progressWriter);
     types::TypesHandler::SizeContext sizeContext;
     types::TypesHandler typesHandler{testGen->types, sizeContext};
 
@@ -578,7 +604,7 @@ Status Server::TestsGenServiceImpl::PrintModulesContent(ServerContext *context,
 
     utbot::ProjectContext projectContext{*request};
     fs::path serverBuildDir = Paths::getUTBotBuildDir(projectContext);
-    std::shared_ptr<ProjectBuildDatabase> buildDatabase = std::make_shared<ProjectBuildDatabase>(projectContext);
+    std::shared_ptr<ProjectBuildDatabase> buildDatabase = ProjectSessionCache::getInstance().getProjectBuildDatabase(projectContext);
     StubSourcesFinder(buildDatabase).printAllModules();
     return Status::OK;
 }
@@ -589,7 +615,6 @@ Status Server::TestsGenServiceImpl::GetSourceCode(ServerContext *context,
     LOG_S(INFO) << "GetSourceCode receive:\n" << request->DebugString();
 
     ServerUtils::setThreadOptions(context, testMode);
-    auto lock = acquireLock();
 
     MEASURE_FUNCTION_EXECUTION_TIME
 
@@ -647,13 +672,12 @@ Status Server::TestsGenServiceImpl::GetProjectTargets(ServerContext *context,
 
 
     ServerUtils::setThreadOptions(context, testMode);
-    auto lock = acquireLock();
 
     MEASURE_FUNCTION_EXECUTION_TIME
 
     try {
         utbot::ProjectContext projectContext{request->projectcontext()};
-        auto buildDatabase = std::make_shared<ProjectBuildDatabase>(projectContext);
+        auto buildDatabase = ProjectSessionCache::getInstance().getSnapshot(projectContext);
         std::vector<fs::path> targets = buildDatabase->getAllTargetPaths();
         ProjectTargetsWriter targetsWriter(response);
         targetsWriter.writeResponse(projectContext, targets);
@@ -669,13 +693,12 @@ Status Server::TestsGenServiceImpl::GetFileTargets(ServerContext *context,
     LOG_S(INFO) << "GetFileTargets receive:\n" << request->DebugString();
 
     ServerUtils::setThreadOptions(context, testMode);
-    auto lock = acquireLock();
 
     MEASURE_FUNCTION_EXECUTION_TIME
 
     try {
         utbot::ProjectContext projectContext{request->projectcontext()};
-        auto buildDatabase = std::make_shared<ProjectBuildDatabase>(projectContext);
+        auto buildDatabase = ProjectSessionCache::getInstance().getSnapshot(projectContext);
         fs::path path = request->path();
         auto targetPaths = buildDatabase->getTargetPathsForSourceFile(path);
         FileTargetsWriter targetsWriter{response};
@@ -686,6 +709,104 @@ Status Server::TestsGenServiceImpl::GetFileTargets(ServerContext *context,
     return Status::OK;
 }
 
+Status Server::TestsGenServiceImpl::GetMetrics(ServerContext *context,
+                                               const DummyRequest *request,
+                                               MetricsResponse *response) {
+    ServerUtils::setThreadOptions(context, testMode);
+
+    for (const auto *callSite : TimeExecStatistics::getCallSites()) {
+        uint64_t count = callSite->count.load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        auto *spanMetrics = response->add_spans();
+        spanMetrics->set_file(callSite->file);
+        spanMetrics->set_function(callSite->function);
+        spanMetrics->set_count(count);
+        spanMetrics->set_totalmicroseconds(callSite->totalMicroseconds.load(std::memory_order_relaxed));
+        spanMetrics->set_maxmicroseconds(callSite->maxMicroseconds.load(std::memory_order_relaxed));
+        for (const auto &bucket : callSite->histogram) {
+            spanMetrics->add_histogram(bucket.load(std::memory_order_relaxed));
+        }
+    }
+    return Status::OK;
+}
+
+Server::KleeWorkerServiceImpl::KleeWorkerServiceImpl(bool testMode) : testMode(testMode) {
+}
+
+Status Server::KleeWorkerServiceImpl::RunKlee(ServerContext *context,
+                                              const KleeRunRequest *request,
+                                              KleeRunResponse *response) {
+    static std::atomic<uint64_t> nextRunId = 0;
+    fs::path kleeOut;
+    try {
+        ServerUtils::setThreadOptions(context, testMode);
+        RequestEnvironment::setPriority(RequestEnvironment::Priority::BATCH);
+        MEASURE_FUNCTION_EXECUTION_TIME
+
+        auto bitcodeFilePath = ArtifactStore::getInstance().get(request->bitcodehash());
+        if (!bitcodeFilePath.has_value()) {
+            return Status(StatusCode::NOT_FOUND,
+                          "No bitcode " + request->bitcodehash() + " in artifact store");
+        }
+        std::string runName = std::to_string(getpid()) + "_" + std::to_string(nextRunId++);
+        // KLEE creates the output directory itself and refuses to reuse an existing one
+        kleeOut = Paths::getKleeWorkerDir() / runName;
+        fs::create_directories(kleeOut.parent_path());
+
+        std::vector<std::string> argvData = { "klee" };
+        argvData.insert(argvData.end(), request->kleearguments().begin(),
+                        request->kleearguments().end());
+        argvData.emplace_back("--output-dir=" + kleeOut.string());
+        argvData.emplace_back(bitcodeFilePath->string());
+        argvData.insert(argvData.end(), request->programarguments().begin(),
+                        request->programarguments().end());
+        std::optional<std::chrono::seconds> timeout;
+        if (request->timeoutseconds() > 0) {
+            timeout = std::chrono::seconds(request->timeoutseconds());
+        }
+
+        std::vector<char *> cargv, cenvp;
+        std::vector<std::string> tmp;
+        ExecUtils::toCArgumentsPtr(argvData, tmp, cargv, cenvp, false);
+        LOG_S(DEBUG) << "Klee command :: " + StringUtils::joinWith(argvData, " ");
+        RunKleeTask task(cargv.size(), cargv.data(), timeout);
+        task.setLogFilePath(Paths::addSuffix(Paths::getKleeTmpLogFilePath(), "_" + runName));
+        ExecUtils::ExecutionResult result = task.run();
+        ExecUtils::throwIfCancelled();
+
+        response->set_status(result.status);
+        if (fs::exists(kleeOut)) {
+            for (const auto &entry : fs::directory_iterator(kleeOut)) {
+                // the same files are removed by KleeRunner before processing ktests
+                if (!entry.is_regular_file() || entry.path().filename() == "assembly.ll" ||
+                    entry.path().filename() == "run.istats") {
+                    continue;
+                }
+                std::ifstream stream(entry.path(), std::ios::binary);
+                auto *file = response->add_files();
+                file->set_name(entry.path().filename().string());
+                file->set_content(std::string(std::istreambuf_iterator<char>(stream),
+                                              std::istreambuf_iterator<char>()));
+            }
+        }
+        FileSystemUtils::removeAll(kleeOut);
+        return Status::OK;
+    } catch (const CancellationException &e) {
+        if (!kleeOut.empty()) {
+            FileSystemUtils::removeAll(kleeOut);
+        }
+        return Status::CANCELLED;
+    } catch (const std::exception &e) {
+        LOG_S(ERROR) << "KLEE worker run failed: " << e.what();
+        if (!kleeOut.empty()) {
+            FileSystemUtils::removeAll(kleeOut);
+        }
+        return Status(StatusCode::INTERNAL, e.what());
+    }
+}
+
 RequestLockMutex &Server::TestsGenServiceImpl::getLock() {
     std::string const &client = RequestEnvironment::getClientId();
     auto[iterator, inserted] = locks.try_emplace(client);
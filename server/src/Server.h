@@ -9,6 +9,7 @@
 #include "exceptions/ExecutionProcessException.h"
 #include "exceptions/NoTestGeneratedException.h"
 #include "printers/TestsPrinter.h"
+#include "streams/LogChannel.h"
 #include "streams/stubs/StubsWriter.h"
 #include "streams/tests/ServerTestsWriter.h"
 #include "streams/tests/TestsWriter.h"
@@ -22,6 +23,7 @@
 #include "testgens/PredicateTestGen.h"
 #include "testgens/ProjectTestGen.h"
 #include "testgens/SnippetTestGen.h"
+#include "utils/ExecUtils.h"
 #include "utils/LogUtils.h"
 #include "utils/RequestLockMutex.h"
 #include "utils/ServerUtils.h"
@@ -108,20 +110,26 @@ public:
                           "Type parameter must derive from BaseTestGen");
             try {
                 LOG_S(INFO) << typeid(RequestT).name() << " receive:\n" << request.DebugString();
-                auto testsWriter = std::make_unique<ServerTestsWriter>(writer, GrpcUtils::synchronizeCode(request));
+                // tests of the request aren't used after they are written
+                auto testsWriter = std::make_unique<ServerTestsWriter>(
+                    writer, GrpcUtils::synchronizeCode(request), true);
 
                 ServerUtils::setThreadOptions(context, testMode);
                 auto lock = acquireLock(testsWriter.get());
+                // request cancelled while waiting for the lock passes it on at once
+                ExecUtils::throwIfCancelled();
 
                 MEASURE_FUNCTION_EXECUTION_TIME
 
                 TestGenT testGen{ request, testsWriter.get(), testMode };
-                TimeExecStatistics::clearStatistic();
+                TimeExecStatistics::RequestScope requestStatistics;
                 Status status = ProcessBaseTestRequest(testGen, testsWriter.get());
                 TimeExecStatistics::printStatistic();
                 return status;
             } catch (const CompilationDatabaseException &e) {
                 return failedToLoadCDbStatus(e);
+            } catch (const CancellationException &e) {
+                return Status::CANCELLED;
             }
         }
 
@@ -186,6 +194,10 @@ public:
                               const FileTargetsRequest *request,
                               FileTargetsResponse *response) override;
 
+        Status GetMetrics(ServerContext *context,
+                          const DummyRequest *request,
+                          MetricsResponse *response) override;
+
 
         static Status ProcessBaseTestRequest(BaseTestGen &testGen, TestsWriter *testsWriter);
 
@@ -198,7 +210,11 @@ public:
         std::map <std::string, TimeUtils::systemClockTimePoint> linkedWithClient;
         std::map <std::string, std::atomic_bool> openedChannel;
         std::map <std::string, std::atomic_bool> openedGTestChannel;
-        std::map <std::string, std::atomic_bool> holdLockFlag;
+        std::mutex logChannelsMutex;
+        /**
+         * Open log channels by names of their loguru callbacks.
+         */
+        std::map<std::string, std::shared_ptr<LogChannel>> logChannels;
         concurrent_set<std::string> clients;
 
         template <class Key, class Value>
@@ -208,6 +224,11 @@ public:
 
         RequestLockMutex &getLock();
 
+        /**
+         * Serializes requests of a client that generate or modify files of its project.
+         * Read-only requests (source code, targets, function return type) don't acquire it and
+         * use immutable build database snapshots, so they aren't blocked by running generation.
+         */
         std::unique_lock<RequestLockMutex> acquireLock(ProgressWriter *writer = nullptr);
 
         static std::shared_ptr<LineInfo> getLineInfo(LineTestGen &lineTestGen);
@@ -221,11 +242,35 @@ public:
                                        std::map<std::string, std::atomic_bool> &channelStorage,
                                        bool openFiles);
 
+        void closeLogChannel(const std::string &callbackName);
+
+        /**
+         * @brief Closes log and gtest channels of the client, so their RPCs return.
+         */
+        void closeLogChannels(const std::string &client);
+
     protected:
         bool testMode = false;
     };
 
+    /**
+     * Runs KLEE for other servers which use this one as a worker, see KleeWorkerPool.
+     * Registered only with `--klee-worker`.
+     */
+    class KleeWorkerServiceImpl final : public KleeWorkerService::Service {
+    public:
+        explicit KleeWorkerServiceImpl(bool testMode = false);
+
+        Status RunKlee(ServerContext *context,
+                       const KleeRunRequest *request,
+                       KleeRunResponse *response) override;
+
+    private:
+        bool testMode = false;
+    };
+
     TestsGenServiceImpl testsService;
+    KleeWorkerServiceImpl kleeWorkerService;
     friend bool LogUtils::logChannelsWatcher(Server &server);
 private:
     std::string host;
@@ -245,15 +290,6 @@ private:
 
     static uint16_t getPort();
 
-    struct WriterData {
-        ServerWriter<LogEntry> *writer;
-        std::mutex writerMutex;
-        const std::string client;
-    };
-
-    //recommended size from loguru
-    const static size_t LOGURU_BUFFER_SIZE = 17;
-
     static void logToClient(void *channel, const loguru::Message &message);
 
     static void gtestLog(void *channel, const loguru::Message &message);
@@ -0,0 +1,182 @@
+#include "SynchronizationManifest.h"
+
+#include "Paths.h"
+#include "exceptions/FileSystemException.h"
+#include "utils/HashUtils.h"
+#include "utils/JsonUtils.h"
+#include "utils/TimeUtils.h"
+
+#include "loguru.h"
+
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+static long long getModificationTime(const fs::path &path) {
+    std::error_code errorCode;
+    auto modificationTime = fs::last_write_time(path, errorCode);
+    if (errorCode) {
+        return -1;
+    }
+    return TimeUtils::convertFileToSystemClock(modificationTime).time_since_epoch().count();
+}
+
+SynchronizationManifest::SynchronizationManifest(
+    const utbot::ProjectContext &projectContext,
+    std::shared_ptr<CompilationDatabase> compilationDatabase)
+    : projectPath(projectContext.projectPath),
+      manifestPath(Paths::getSynchronizationManifestPath(projectContext)),
+      compilationDatabase(std::move(compilationDatabase)) {
+    if (!fs::exists(manifestPath)) {
+        return;
+    }
+    try {
+        auto json = JsonUtils::getJsonFromFile(manifestPath);
+        for (const auto &[relativeSourcePath, entryJson] : json.items()) {
+            SourceEntry entry;
+            entry.modificationTime = entryJson.at("modificationTime").get<long long>();
+            entry.sourceHash = entryJson.at("sourceHash").get<std::size_t>();
+            for (const auto &[name, artifactJson] : entryJson.at("artifacts").items()) {
+                entry.artifacts[name] = { artifactJson.at("sourceHash").get<std::size_t>(),
+                                          artifactJson.at("flagsHash").get<std::size_t>() };
+            }
+            entries[projectPath / relativeSourcePath] = std::move(entry);
+        }
+        loaded = true;
+    } catch (const std::exception &e) {
+        // everything is regenerated, as if the manifest had never existed
+        LOG_S(WARNING) << "Synchronization manifest " << manifestPath << " is broken: " << e.what();
+        entries.clear();
+    }
+}
+
+bool SynchronizationManifest::isLoaded() const {
+    return loaded;
+}
+
+bool SynchronizationManifest::isOutdated(const fs::path &sourcePath,
+                                         Artifact artifact,
+                                         const std::optional<fs::path> &artifactPath) {
+    if (artifactPath.has_value() && !fs::exists(artifactPath.value())) {
+        return true;
+    }
+    SourceState state = getSourceState(sourcePath);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto entryIt = entries.find(sourcePath);
+    if (entryIt == entries.end()) {
+        return true;
+    }
+    auto artifactIt = entryIt->second.artifacts.find(getArtifactName(artifact));
+    if (artifactIt == entryIt->second.artifacts.end()) {
+        return true;
+    }
+    return artifactIt->second.sourceHash != state.sourceHash ||
+           artifactIt->second.flagsHash != state.flagsHash;
+}
+
+void SynchronizationManifest::update(const fs::path &sourcePath, Artifact artifact) {
+    SourceState state = getSourceState(sourcePath);
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[sourcePath].artifacts[getArtifactName(artifact)] = { state.sourceHash, state.flagsHash };
+}
+
+void SynchronizationManifest::remove(const fs::path &sourcePath, Artifact artifact) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto it = entries.find(sourcePath); it != entries.end()) {
+        it->second.artifacts.erase(getArtifactName(artifact));
+    }
+}
+
+CollectionUtils::FileSet SynchronizationManifest::getSourcePaths(Artifact artifact) const {
+    std::string name = getArtifactName(artifact);
+    std::lock_guard<std::mutex> lock(mutex);
+    CollectionUtils::FileSet sourcePaths;
+    for (const auto &[sourcePath, entry] : entries) {
+        if (CollectionUtils::containsKey(entry.artifacts, name)) {
+            sourcePaths.insert(sourcePath);
+        }
+    }
+    return sourcePaths;
+}
+
+void SynchronizationManifest::save() const {
+    JsonUtils::json json = JsonUtils::json::object();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &[sourcePath, entry] : entries) {
+            JsonUtils::json artifactsJson = JsonUtils::json::object();
+            for (const auto &[name, artifactState] : entry.artifacts) {
+                artifactsJson[name] = { { "sourceHash", artifactState.sourceHash },
+                                        { "flagsHash", artifactState.flagsHash } };
+            }
+            json[fs::relative(sourcePath, projectPath).string()] = {
+                { "modificationTime", entry.modificationTime },
+                { "sourceHash", entry.sourceHash },
+                { "artifacts", artifactsJson }
+            };
+        }
+    }
+    // concurrent readers see either the old manifest or the new one, never a partial file
+    fs::path temporaryPath = Paths::addExtension(manifestPath, "." + std::to_string(getpid()));
+    JsonUtils::writeJsonToFile(temporaryPath, json);
+    try {
+        fs::rename(temporaryPath, manifestPath);
+    } catch (const fs::filesystem_error &e) {
+        throw FileSystemException("Failed to save synchronization manifest", e);
+    }
+}
+
+std::string SynchronizationManifest::getArtifactName(Artifact artifact) {
+    switch (artifact) {
+    case Artifact::STUB:
+        return "stub";
+    case Artifact::STUB_HEADER:
+        return "stubHeader";
+    case Artifact::WRAPPER:
+        return "wrapper";
+    }
+    return "";
+}
+
+SynchronizationManifest::SourceState
+SynchronizationManifest::getSourceState(const fs::path &sourcePath) {
+    long long modificationTime = getModificationTime(sourcePath);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto it = sourceStates.find(sourcePath); it != sourceStates.end()) {
+            return it->second;
+        }
+        auto entryIt = entries.find(sourcePath);
+        if (entryIt != entries.end() && entryIt->second.modificationTime == modificationTime) {
+            SourceState state{ entryIt->second.sourceHash, getFlagsHash(sourcePath) };
+            sourceStates[sourcePath] = state;
+            return state;
+        }
+    }
+
+    // the source is touched or changed, only its content tells which one
+    std::ifstream sourceFile(sourcePath);
+    std::stringstream content;
+    content << sourceFile.rdbuf();
+    SourceState state{ std::hash<std::string>()(content.str()), getFlagsHash(sourcePath) };
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &entry = entries[sourcePath];
+    entry.modificationTime = modificationTime;
+    entry.sourceHash = state.sourceHash;
+    sourceStates[sourcePath] = state;
+    return state;
+}
+
+std::size_t SynchronizationManifest::getFlagsHash(const fs::path &sourcePath) const {
+    std::size_t flagsHash = 0;
+    auto compileCommands =
+        compilationDatabase->getClangCompilationDatabase().getCompileCommands(sourcePath.string());
+    for (const auto &compileCommand : compileCommands) {
+        HashUtils::hashCombine(flagsHash, compileCommand.Directory);
+        for (const std::string &argument : compileCommand.CommandLine) {
+            HashUtils::hashCombine(flagsHash, argument);
+        }
+    }
+    return flagsHash;
+}
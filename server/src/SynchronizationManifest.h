@@ -0,0 +1,94 @@
+#ifndef UNITTESTBOT_SYNCHRONIZATIONMANIFEST_H
+#define UNITTESTBOT_SYNCHRONIZATIONMANIFEST_H
+
+#include "ProjectContext.h"
+#include "building/CompilationDatabase.h"
+#include "utils/CollectionUtils.h"
+
+#include "utils/path/FileSystemPath.h"
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Records what stubs, stub headers and wrappers of a project were generated from.
+ *
+ * For every artifact the manifest keeps hashes of the source content and of the source
+ * compilation flags. An artifact is outdated only if one of the inputs has really changed, so touching files (e.g. by `git checkout`) doesn't trigger
+ * regeneration. Sources are read only if their modification time differs from the recorded
+ * one. The manifest is loaded once per synchronization and saved atomically.
+ */
+class SynchronizationManifest {
+public:
+    enum class Artifact { STUB, STUB_HEADER, WRAPPER };
+
+    SynchronizationManifest(const utbot::ProjectContext &projectContext,
+                            std::shared_ptr<CompilationDatabase> compilationDatabase);
+
+    /**
+     * @return false if the manifest is absent or broken, so it knows nothing about existing
+     * artifacts.
+     */
+    [[nodiscard]] bool isLoaded() const;
+
+    /**
+     * @param artifactPath generated file, it must exist unless it is std::nullopt.
+     */
+    bool isOutdated(const fs::path &sourcePath,
+                    Artifact artifact,
+                    const std::optional<fs::path> &artifactPath);
+
+    /**
+     * @brief Records that the artifact has been generated from the current source.
+     */
+    void update(const fs::path &sourcePath, Artifact artifact);
+
+    void remove(const fs::path &sourcePath, Artifact artifact);
+
+    /**
+     * @return sources the artifact has been generated for.
+     */
+    [[nodiscard]] CollectionUtils::FileSet getSourcePaths(Artifact artifact) const;
+
+    void save() const;
+
+private:
+    struct ArtifactState {
+        std::size_t sourceHash;
+        std::size_t flagsHash;
+    };
+
+    struct SourceEntry {
+        long long modificationTime = 0;
+        std::size_t sourceHash = 0;
+        std::unordered_map<std::string, ArtifactState> artifacts;
+    };
+
+    struct SourceState {
+        std::size_t sourceHash;
+        std::size_t flagsHash;
+    };
+
+    static std::string getArtifactName(Artifact artifact);
+
+    SourceState getSourceState(const fs::path &sourcePath);
+
+    std::size_t getFlagsHash(const fs::path &sourcePath) const;
+
+    fs::path projectPath;
+    fs::path manifestPath;
+    std::shared_ptr<CompilationDatabase> compilationDatabase;
+    bool loaded = false;
+
+    mutable std::mutex mutex;
+    CollectionUtils::MapFileTo<SourceEntry> entries;
+    /**
+     * States of sources computed during this synchronization, each source is read at most once.
+     */
+    CollectionUtils::MapFileTo<SourceState> sourceStates;
+};
+
+
+#endif // UNITTESTBOT_SYNCHRONIZATIONMANIFEST_H
@@ -7,14 +7,15 @@
 #include "printers/SourceWrapperPrinter.h"
 #include "printers/StubsPrinter.h"
 #include "streams/stubs/StubsWriter.h"
+#include "stubs/StubsIndex.h"
 #include "testgens/SnippetTestGen.h"
 #include "utils/TypeUtils.h"
 
 #include "loguru.h"
 
+#include <algorithm>
 #include <iterator>
 #include <utility>
-#include <fstream>
 
 using StubSet = std::unordered_set<StubOperator, HashUtils::StubHash>;
 
@@ -44,36 +45,33 @@ Synchronizer::Synchronizer(BaseTestGen *testGen,
     : testGen(testGen), sizeContext(sizeContext) {
 }
 
-bool Synchronizer::isProbablyOutdated(const fs::path &srcFilePath) const {
-    fs::path stubFilePath = Paths::sourcePathToStubPath(testGen->projectContext, srcFilePath);
-    if (!fs::exists(stubFilePath)) {
-        return true;
-    }
-    std::ifstream stubFile(stubFilePath);
-    std::string sLine;
-    getline(stubFile, sLine);
-    long long stubTimestamp, srcTimestamp;
-    try {
-        stubTimestamp = std::stoll(sLine.substr(2));
-    } catch (...) {
-        return true;
+bool Synchronizer::isOutdated(const StubOperator &stub) const {
+    auto artifact = stub.isHeader() ? SynchronizationManifest::Artifact::STUB_HEADER
+                                    : SynchronizationManifest::Artifact::STUB;
+    return manifest->isOutdated(stub.getSourceFilePath(), artifact,
+                                stub.getStubPath(testGen->projectContext));
+}
+
+bool Synchronizer::isWrapperOutdated(const fs::path &sourcePath) const {
+    // wrappers are not written for C++ sources
+    std::optional<fs::path> wrapperFilePath;
+    if (!Paths::isCXXFile(sourcePath)) {
+        wrapperFilePath = Paths::getWrapperFilePath(testGen->projectContext, sourcePath);
     }
-    srcTimestamp = TimeUtils::convertFileToSystemClock(fs::last_write_time(srcFilePath))
-                       .time_since_epoch()
-                       .count();
-    return stubTimestamp <= srcTimestamp;
+    return manifest->isOutdated(sourcePath, SynchronizationManifest::Artifact::WRAPPER,
+                                wrapperFilePath);
 }
 
 CollectionUtils::FileSet Synchronizer::getOutdatedSourcePaths() const {
     return CollectionUtils::filterOut(getSourceFiles(), [this](fs::path const &sourcePath) {
-        return !isProbablyOutdated(sourcePath);
+        return !isWrapperOutdated(sourcePath);
     });
 }
 
 StubSet Synchronizer::getOutdatedStubs() const {
     auto allFiles = getStubsFiles();
     auto outdatedStubs = CollectionUtils::filterOut(allFiles, [this](StubOperator const &stubOperator) {
-        return !isProbablyOutdated(stubOperator.getSourceFilePath());
+        return !isOutdated(stubOperator);
     });
     return outdatedStubs;
 }
@@ -120,26 +118,23 @@ void Synchronizer::synchronize(const types::TypesHandler &typesHandler) {
     if (TypeUtils::isSameType<SnippetTestGen>(*this->testGen)) {
         return;
     }
+    manifest = std::make_unique<SynchronizationManifest>(
+        testGen->projectContext, testGen->getProjectBuildDatabase()->compilationDatabase);
     if (testGen->settingsContext.useStubs) {
+        auto stubDirPath = Paths::getStubsDirPath(testGen->projectContext);
+        prepareDirectory(stubDirPath);
         auto outdatedStubs = getOutdatedStubs();
         synchronizeStubs(outdatedStubs, typesHandler);
     }
     auto outdatedSourcePaths = getOutdatedSourcePaths();
     synchronizeWrappers(outdatedSourcePaths);
+    manifest->save();
 }
 
 void Synchronizer::synchronizeStubs(StubSet &outdatedStubs,
                                     const types::TypesHandler &typesHandler) {
-    StubSet allStubs = getStubsFiles();
-    auto stubDirPath = Paths::getStubsDirPath(testGen->projectContext);
-    prepareDirectory(stubDirPath);
-    auto filesInFolder = Paths::findFilesInFolder(stubDirPath);
-    auto presentStubs = CollectionUtils::transformTo<StubSet>(
-    dropHeaders(filesInFolder), [this](const fs::path &stubPath) {
-        return StubOperator(Paths::stubPathToSourcePath(this->testGen->projectContext, stubPath),
-                            Paths::isHeaderFile(stubPath));
-    });
-    StubSet stubFiles = CollectionUtils::unionSet(allStubs, presentStubs);
+    // stubs of sources out of the project are removed by prepareDirectory
+    StubSet stubFiles = getStubsFiles();
     tests::TestsMap stubFilesMap, sourceFilesMap;
     for (const auto &outdatedStub : outdatedStubs) {
         removeStubIfSourceAbsent(outdatedStub);
@@ -163,16 +158,43 @@ void Synchronizer::synchronizeStubs(StubSet &outdatedStubs,
             Paths::getUTBotBuildDir(testGen->projectContext) / "stubs_build_files";
     auto stubsCdb = createStubsCompilationDatabase(stubFiles, ccJsonStubDirPath);
 
-    auto sourceToHeaderRewriter =
-    SourceToHeaderRewriter(testGen->projectContext, testGen->getProjectBuildDatabase()->compilationDatabase,
-                           stubFetcher.getStructsToDeclare(), testGen->serverBuildDir);
+    // stubs are merged in a fixed order, so the result doesn't depend on threads scheduling
+    std::vector<StubOperator> orderedStubs(outdatedStubs.begin(), outdatedStubs.end());
+    std::sort(orderedStubs.begin(), orderedStubs.end(),
+              [this](const StubOperator &lhs, const StubOperator &rhs) {
+                  return lhs.getStubPath(testGen->projectContext) <
+                         rhs.getStubPath(testGen->projectContext);
+              });
+    std::vector<size_t> stubHeaderIndices;
+    for (size_t i = 0; i < orderedStubs.size(); i++) {
+        if (orderedStubs[i].isHeader()) {
+            stubHeaderIndices.push_back(i);
+        }
+    }
+    std::vector<std::string> stubHeaders(orderedStubs.size());
+    auto structsToDeclare = stubFetcher.getStructsToDeclare();
+    ExecUtils::doWorkWithProgressInParallel(
+        stubHeaderIndices, testGen->progressWriter, "Generating stub headers", [&]() {
+            // rewriter keeps state of the current run, so each thread needs its own one
+            auto sourceToHeaderRewriter = std::make_unique<SourceToHeaderRewriter>(
+                testGen->projectContext, testGen->getProjectBuildDatabase()->compilationDatabase,
+                structsToDeclare, testGen->serverBuildDir);
+            return [&, sourceToHeaderRewriter = std::move(sourceToHeaderRewriter)](size_t index) {
+                stubHeaders[index] = sourceToHeaderRewriter->generateStubHeader(
+                    orderedStubs[index].getSourceFilePath());
+            };
+        });
 
-    for (const StubOperator &outdatedStub : outdatedStubs) {
+    // types handler caches answers and isn't thread-safe, stub files are printed serially
+    CollectionUtils::MapFileTo<std::vector<std::string>> stubSymbols;
+    for (size_t i = 0; i < orderedStubs.size(); i++) {
+        const StubOperator &outdatedStub = orderedStubs[i];
         fs::path stubPath = outdatedStub.getStubPath(testGen->projectContext);
         Tests const &methodDescription = stubFilesMap[stubPath];
         if (outdatedStub.isHeader()) {
-            std::string code = sourceToHeaderRewriter.generateStubHeader(outdatedStub.getSourceFilePath());
-            testGen->synchronizedStubs.emplace_back(stubPath, code);
+            testGen->synchronizedStubs.emplace_back(stubPath, stubHeaders[i]);
+            manifest->update(outdatedStub.getSourceFilePath(),
+                             SynchronizationManifest::Artifact::STUB_HEADER);
         } else {
             tests::Tests newStubFile = StubGen::mergeSourceFileIntoStub(
                 methodDescription, sourceFilesMap.at(outdatedStub.getSourceFilePath()));
@@ -180,9 +202,29 @@ void Synchronizer::synchronizeStubs(StubSet &outdatedStubs,
             Stubs stubFile =
                 stubsPrinter.genStubFile(newStubFile, typesHandler, testGen->projectContext);
             testGen->synchronizedStubs.emplace_back(stubFile);
+            manifest->update(outdatedStub.getSourceFilePath(),
+                             SynchronizationManifest::Artifact::STUB);
+            stubSymbols[stubPath] = CollectionUtils::getKeys(newStubFile.methods);
         }
     }
     StubsWriter::writeStubsFilesOnServer(testGen->synchronizedStubs, testGen->projectContext.testDirPath);
+    updateStubsIndex(outdatedStubs, stubSymbols);
+}
+
+void Synchronizer::updateStubsIndex(
+    const StubSet &outdatedStubs,
+    const CollectionUtils::MapFileTo<std::vector<std::string>> &stubSymbols) const {
+    StubsIndex stubsIndex(testGen->projectContext);
+    for (const StubOperator &outdatedStub : dropHeaders(outdatedStubs)) {
+        fs::path stubPath = outdatedStub.getStubPath(testGen->projectContext);
+        auto it = stubSymbols.find(stubPath);
+        if (it != stubSymbols.end() && fs::exists(stubPath)) {
+            stubsIndex.update(stubPath, it->second);
+        } else {
+            stubsIndex.remove(stubPath);
+        }
+    }
+    stubsIndex.save();
 }
 
 std::shared_ptr<CompilationDatabase>
@@ -196,24 +238,18 @@ Synchronizer::createStubsCompilationDatabase(StubSet &stubFiles,
 }
 
 void Synchronizer::synchronizeWrappers(const CollectionUtils::FileSet &outdatedSourcePaths) const {
-    auto sourceFilesNeedToRegenerateWrappers = outdatedSourcePaths;
-    for (fs::path const &sourceFilePath : getSourceFiles()) {
-        if (!CollectionUtils::contains(sourceFilesNeedToRegenerateWrappers, sourceFilePath)) {
-            auto wrapperFilePath =
-                Paths::getWrapperFilePath(testGen->projectContext, sourceFilePath);
-            if (!fs::exists(wrapperFilePath)) {
-                sourceFilesNeedToRegenerateWrappers.insert(sourceFilePath);
-            }
-        }
-    }
-    ExecUtils::doWorkWithProgress(
-        sourceFilesNeedToRegenerateWrappers, testGen->progressWriter,
-        "Generating wrappers", [this](fs::path const &sourceFilePath) {
-            SourceToHeaderRewriter sourceToHeaderRewriter(testGen->projectContext,
-                                                          testGen->getProjectBuildDatabase()->compilationDatabase, nullptr,
-                                                          testGen->serverBuildDir);
-            std::string wrapper = sourceToHeaderRewriter.generateWrapper(sourceFilePath);
-            printer::SourceWrapperPrinter(Paths::getSourceLanguage(sourceFilePath)).print(testGen->projectContext, sourceFilePath, wrapper);
+    ExecUtils::doWorkWithProgressInParallel(
+        outdatedSourcePaths, testGen->progressWriter, "Generating wrappers", [this]() {
+            auto sourceToHeaderRewriter = std::make_unique<SourceToHeaderRewriter>(
+                testGen->projectContext, testGen->getProjectBuildDatabase()->compilationDatabase,
+                nullptr, testGen->serverBuildDir);
+            return [this, sourceToHeaderRewriter = std::move(sourceToHeaderRewriter)](
+                       fs::path const &sourceFilePath) {
+                std::string wrapper = sourceToHeaderRewriter->generateWrapper(sourceFilePath);
+                printer::SourceWrapperPrinter(Paths::getSourceLanguage(sourceFilePath))
+                    .print(testGen->projectContext, sourceFilePath, wrapper);
+                manifest->update(sourceFilePath, SynchronizationManifest::Artifact::WRAPPER);
+            };
         });
 }
 
@@ -227,6 +263,29 @@ StubSet Synchronizer::getStubsFiles() const {
 
 void Synchronizer::prepareDirectory(const fs::path &stubDirectory) {
     fs::create_directories(stubDirectory);
+    // functions of removed stubs must not be found by the linker any more
+    StubsIndex stubsIndex(testGen->projectContext);
+    bool stubsRemoved = false;
+    auto removeStub = [&](const fs::path &stubPath) {
+        LOG_S(DEBUG) << "Found extra file in stub directory: " << stubPath << ". Removing it.";
+        fs::remove(stubPath);
+        stubsIndex.remove(stubPath);
+        stubsRemoved = true;
+    };
+    if (manifest->isLoaded()) {
+        // every stub has been generated by synchronization, so the manifest lists all of them
+        for (const fs::path &sourcePath :
+             manifest->getSourcePaths(SynchronizationManifest::Artifact::STUB)) {
+            if (!CollectionUtils::contains(getSourceFiles(), sourcePath)) {
+                removeStub(Paths::sourcePathToStubPath(testGen->projectContext, sourcePath));
+                manifest->remove(sourcePath, SynchronizationManifest::Artifact::STUB);
+            }
+        }
+        if (stubsRemoved) {
+            stubsIndex.save();
+        }
+        return;
+    }
     for (const auto &entry : fs::recursive_directory_iterator(stubDirectory)) {
         if (entry.is_regular_file()) {
             fs::path stubPath = entry.path();
@@ -234,11 +293,12 @@ void Synchronizer::prepareDirectory(const fs::path &stubDirectory) {
                 fs::path sourcePath =
                     Paths::stubPathToSourcePath(testGen->projectContext, stubPath);
                 if (!CollectionUtils::contains(getSourceFiles(), sourcePath)) {
-                    LOG_S(DEBUG) << "Found extra file in stub directory: " << stubPath
-                                 << ". Removing it.";
-                    fs::remove(stubPath);
+                    removeStub(stubPath);
                 }
             }
         }
     }
+    if (stubsRemoved) {
+        stubsIndex.save();
+    }
 }
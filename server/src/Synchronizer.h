@@ -2,6 +2,7 @@
 #define UNITTESTBOT_SYNCHRONIZER_H
 
 #include "ProjectContext.h"
+#include "SynchronizationManifest.h"
 
 #include "stubs/StubGen.h"
 #include "types/Types.h"
@@ -22,12 +23,18 @@ private:
 class Synchronizer {
     BaseTestGen *const testGen;
     types::TypesHandler::SizeContext *sizeContext;
+    /**
+     * Loaded once per synchronization, all outdated artifacts are found with it.
+     */
+    std::unique_ptr<SynchronizationManifest> manifest;
 
     [[nodiscard]] CollectionUtils::FileSet getOutdatedSourcePaths() const;
 
     [[nodiscard]] std::unordered_set<StubOperator, HashUtils::StubHash> getOutdatedStubs() const;
 
-    bool isProbablyOutdated(const fs::path &srcFilePath) const;
+    bool isOutdated(const StubOperator &stub) const;
+
+    bool isWrapperOutdated(const fs::path &sourcePath) const;
 
     bool removeStubIfSourceAbsent(const StubOperator &stub) const;
 
@@ -35,6 +42,13 @@ class Synchronizer {
                           const types::TypesHandler &typesHandler);
     void synchronizeWrappers(const CollectionUtils::FileSet &outdatedSourcePaths) const;
 
+    /**
+     * @brief Records functions of regenerated stubs in StubsIndex, so StubGen doesn't parse them.
+     */
+    void updateStubsIndex(
+        const std::unordered_set<StubOperator, HashUtils::StubHash> &outdatedStubs,
+        const CollectionUtils::MapFileTo<std::vector<std::string>> &stubSymbols) const;
+
     std::shared_ptr<CompilationDatabase>
     createStubsCompilationDatabase(
         std::unordered_set<StubOperator, HashUtils::StubHash> &stubFiles,
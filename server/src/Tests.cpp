@@ -33,6 +33,30 @@ Tests::MethodDescription::MethodDescription()
                    { Tests::ERROR_SUITE_NAME,   std::string() }},
           modifiers{} { }
 
+template <typename T>
+static void release(T &value) {
+    T().swap(value);
+}
+
+void Tests::releaseGeneratedCode() {
+    for (auto it = methods.begin(); it != methods.end(); ++it) {
+        MethodDescription &method = it.value();
+        release(method.testCases);
+        release(method.stubsText);
+        // suites stay, code of both default suites is looked up by name
+        for (auto &[suiteName, code] : method.codeText) {
+            release(code);
+        }
+        for (auto &[suiteName, testCases] : method.suiteTestCases) {
+            release(testCases);
+        }
+    }
+    release(code);
+    release(headerCode);
+    release(commentBlocks);
+    release(stubs);
+}
+
 static const std::unordered_map<std::string, std::string> FPSpecialValuesMappings = {
     {"nan", "NAN"},
     {"-nan", "-NAN"},
@@ -459,6 +459,8 @@ namespace tests {
             bool hasIncompleteReturnType = false;
 
             std::optional<std::string> sourceBody;
+            // hash of IR reachable from the KLEE entrypoint of the method, set by IRParser
+            std::string irFingerprint;
             Modifiers modifiers;
             bool isVariadic = false;
             std::vector<MethodParam> globalParams;
@@ -569,6 +571,15 @@ namespace tests {
 
         bool isFilePresentedInCommands = true;
         bool isFilePresentedInArtifact = true;
+
+        /**
+         * @brief Frees test cases and generated code of the file once it is written.
+         *
+         * Method descriptions, paths and counters stay, so the file is still known to the
+         * request. The memory is released, not only cleared, since a project run keeps
+         * all files till its end.
+         */
+        void releaseGeneratedCode();
     };
 
     typedef CollectionUtils::OrderedMapFileTo<Tests> TestsMap;
@@ -1,60 +1,181 @@
 #include "TimeExecStatistics.h"
 
-#include "utils/CollectionUtils.h"
+#include "Paths.h"
+#include "commands/Commands.h"
+#include "utils/JsonUtils.h"
 #include "utils/StringUtils.h"
 
 #include "loguru.h"
 
+#include <algorithm>
+#include <mutex>
+#include <unistd.h>
 #include <utility>
 
 static thread_local double maxDurationMs = 0;
 static const std::string SUMMARY_DELIMITER = " | ";
-thread_local std::
-    unordered_map<TimeExecStatistics::Caller, std::vector<double>, TimeExecStatistics::CallerHash>
-        statistic;
+struct RequestSummary {
+    uint64_t count = 0;
+    double totalDurationMs = 0;
+};
+// durations of the current request, bounded by the number of call sites
+static thread_local std::unordered_map<const TimeExecStatistics::CallSite *, RequestSummary> statistic;
 static const std::vector<std::string> HEADERS({ "Function", "% of overall", "Total time (ms)",
                                       "Times called" });
 static const size_t COLUMNS_NUMBER = 4;
 
-TimeExecStatistics::Caller::Caller(std::string file, std::string function)
-    : file(std::move(file)), function(std::move(function)) {
-}
+class TimeExecStatistics::Trace {
+public:
+    explicit Trace(uint64_t requestId) : requestId(requestId) {
+    }
 
-std::string TimeExecStatistics::Caller::get() const {
-    return file + " " + function;
-}
+    void addSpan(const std::string &name,
+                 std::chrono::steady_clock::time_point begin,
+                 std::chrono::steady_clock::time_point end) {
+        static std::atomic_uint64_t nextThreadId = 0;
+        static thread_local uint64_t threadId = nextThreadId++;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spans.size() >= MAX_SPANS) {
+            ++droppedSpans;
+            return;
+        }
+        spans.push_back({ name, begin, end, threadId });
+    }
+
+    void save() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto toMicroseconds = [](std::chrono::steady_clock::duration duration) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        };
+        JsonUtils::json events = JsonUtils::json::array();
+        for (const auto &span : spans) {
+            events.push_back({ { "name", span.name },
+                               { "ph", "X" },
+                               { "ts", toMicroseconds(span.begin.time_since_epoch()) },
+                               { "dur", toMicroseconds(span.end - span.begin) },
+                               { "pid", getpid() },
+                               { "tid", span.threadId },
+                               { "args", { { "requestId", requestId } } } });
+        }
+        fs::path tracePath = Paths::getTracePath(requestId);
+        JsonUtils::writeJsonToFile(tracePath, { { "traceEvents", events },
+                                                { "displayTimeUnit", "ms" } });
+        LOG_S(DEBUG) << "Trace of the request is saved to " << tracePath;
+        LOG_IF_S(WARNING, droppedSpans > 0) << droppedSpans << " spans were dropped from the trace";
+    }
+
+private:
+    struct Span {
+        std::string name;
+        std::chrono::steady_clock::time_point begin, end;
+        uint64_t threadId;
+    };
+
+    static constexpr size_t MAX_SPANS = 1 << 18;
 
-bool TimeExecStatistics::Caller::operator==(const TimeExecStatistics::Caller &other) const {
-    return this->get() == other.get();
+    const uint64_t requestId;
+    mutable std::mutex mutex;
+    std::vector<Span> spans;
+    uint64_t droppedSpans = 0;
+};
+
+static thread_local std::shared_ptr<TimeExecStatistics::Trace> currentTrace;
+
+static std::mutex callSitesMutex;
+static std::vector<const TimeExecStatistics::CallSite *> callSites;
+
+TimeExecStatistics::CallSite::CallSite(const fs::path &file, std::string function, uint32_t line)
+    : file(file.filename().string() + ":" + std::to_string(line)), function(std::move(function)) {
+    std::lock_guard<std::mutex> lock(callSitesMutex);
+    callSites.push_back(this);
 }
 
-std::ostream &operator<<(std::ostream &os, const TimeExecStatistics::Caller &caller) {
-    os << caller.get();
-    return os;
+std::string TimeExecStatistics::CallSite::get() const {
+    return file + " " + function;
 }
 
-std::size_t
-TimeExecStatistics::CallerHash::operator()(const TimeExecStatistics::Caller &caller) const {
-    return std::hash<std::string>()(caller.get());
+void TimeExecStatistics::CallSite::record(uint64_t microseconds) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    totalMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+    uint64_t max = maxMicroseconds.load(std::memory_order_relaxed);
+    while (microseconds > max &&
+           !maxMicroseconds.compare_exchange_weak(max, microseconds, std::memory_order_relaxed)) {
+    }
+    size_t bucket = 0;
+    for (uint64_t milliseconds = microseconds / 1000; milliseconds > 0; milliseconds >>= 1) {
+        ++bucket;
+    }
+    histogram[std::min(bucket, HISTOGRAM_BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
 }
 
-TimeExecStatistics::TimeExecStatistics(const fs::path &file, const std::string &function, uint32_t line)
-    : currentCaller({ file.filename().string() + ":" + std::to_string(line), function }),
-      begin(std::chrono::steady_clock::now()) {
+TimeExecStatistics::TimeExecStatistics(CallSite &callSite, std::string traceName)
+    : callSite(callSite), traceName(std::move(traceName)), begin(std::chrono::steady_clock::now()) {
 }
 
 TimeExecStatistics::~TimeExecStatistics() {
-    const auto duration = std::chrono::steady_clock::now() - begin;
+    const auto end = std::chrono::steady_clock::now();
+    const auto duration = end - begin;
+    uint64_t durationUs = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
     double durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
     if (durationMs > maxDurationMs) {
         maxDurationMs = durationMs;
     }
-    LOG_S(MAX) << "Execution Time for " << currentCaller.get() << " is " << durationMs << " ms";
-    statistic[currentCaller].push_back(durationMs);
+    LOG_S(MAX) << "Execution Time for " << callSite.get() << " is " << durationMs << " ms";
+    callSite.record(durationUs);
+    auto &summary = statistic[&callSite];
+    ++summary.count;
+    summary.totalDurationMs += durationMs;
+    if (currentTrace != nullptr) {
+        currentTrace->addSpan(traceName.empty() ? callSite.function : traceName, begin, end);
+    }
 }
 
 void TimeExecStatistics::clearStatistic() {
+    static std::atomic_uint64_t nextRequestId = 0;
     statistic.clear();
+    maxDurationMs = 0;
+    currentTrace = Commands::traceRequests ? std::make_shared<Trace>(nextRequestId++) : nullptr;
+}
+
+TimeExecStatistics::CallSite &TimeExecStatistics::getProcessCallSite(const fs::path &executable) {
+    // every test binary is a distinct executable, so rarely seen ones share a call site
+    static constexpr size_t MAX_PROCESS_CALL_SITES = 64;
+    static std::mutex processCallSitesMutex;
+    static std::unordered_map<std::string, std::unique_ptr<CallSite>> processCallSites;
+    std::string name = executable.filename().string();
+    std::lock_guard<std::mutex> lock(processCallSitesMutex);
+    if (processCallSites.size() >= MAX_PROCESS_CALL_SITES &&
+        processCallSites.find(name) == processCallSites.end()) {
+        name = "other";
+    }
+    auto &callSite = processCallSites[name];
+    if (callSite == nullptr) {
+        callSite = std::make_unique<CallSite>("process", name, 0);
+    }
+    return *callSite;
+}
+
+std::vector<const TimeExecStatistics::CallSite *> TimeExecStatistics::getCallSites() {
+    std::lock_guard<std::mutex> lock(callSitesMutex);
+    return callSites;
+}
+
+std::shared_ptr<TimeExecStatistics::Trace> TimeExecStatistics::getTrace() {
+    return currentTrace;
+}
+
+void TimeExecStatistics::setTrace(std::shared_ptr<Trace> trace) {
+    currentTrace = std::move(trace);
+}
+
+TimeExecStatistics::RequestScope::RequestScope() {
+    clearStatistic();
+}
+
+TimeExecStatistics::RequestScope::~RequestScope() {
+    statistic.clear();
+    maxDurationMs = 0;
+    currentTrace = nullptr;
 }
 
 void TimeExecStatistics::printStatistic() {
@@ -63,11 +184,15 @@ void TimeExecStatistics::printStatistic() {
     for (size_t i = 0; i < COLUMNS_NUMBER; i++) {
         columnsWidth[i] = HEADERS[i].size();
     }
-    for (const auto &[name, durations] : statistic) {
-        auto currentSummary = getFunctionSummary(name);
+    for (const auto &[callSite, summary] : statistic) {
+        auto currentSummary = getFunctionSummary(callSite);
         tupleFor<COLUMNS_NUMBER>([&](auto i) {
             std::stringstream ss;
-            ss << std::get<i.value>(currentSummary);
+            if constexpr (decltype(i)::value == 0) {
+                ss << std::get<0>(currentSummary)->get();
+            } else {
+                ss << std::get<i.value>(currentSummary);
+            }
             columnsWidth[i.value] = std::max(columnsWidth[i.value], ss.str().size());
         });
         summaryTable.push_back(currentSummary);
@@ -91,11 +216,11 @@ void TimeExecStatistics::printStatistic() {
             switch (i.value) {
             case 0:
                 statsStream << std::setw(columnsWidth[0])
-                            << (std::get<0>(row).file +
+                            << (std::get<0>(row)->file +
                                 StringUtils::repeat(" ", columnsWidth[0] -
-                                                             std::get<0>(row).file.size() -
-                                                             std::get<0>(row).function.size()) +
-                                std::get<0>(row).function);
+                                                             std::get<0>(row)->file.size() -
+                                                             std::get<0>(row)->function.size()) +
+                                std::get<0>(row)->function);
                 break;
             case 1:
                 statsStream << std::setw(columnsWidth[1]) << std::fixed << std::setprecision(2)
@@ -111,21 +236,18 @@ void TimeExecStatistics::printStatistic() {
     }
     printRowDelimiter(statsStream, columnsWidth);
     LOG_S(DEBUG) << statsStream.str();
+    if (currentTrace != nullptr) {
+        currentTrace->save();
+        currentTrace = nullptr;
+    }
 }
 
-std::tuple<TimeExecStatistics::Caller, double, uint64_t, uint64_t>
-TimeExecStatistics::getFunctionSummary(const Caller &function) {
-    double totalDuration = 0, pctOfTotalExecutionTime, timesCalled;
-    if (!CollectionUtils::containsKey(statistic, function) || statistic[function].size() == 0) {
-        return { Caller("", ""), 0, 0, 0 };
-    }
-    const auto &durations = statistic[function];
-    for (auto d : durations) {
-        totalDuration += d;
-    }
-    timesCalled = durations.size();
-    pctOfTotalExecutionTime = (totalDuration / maxDurationMs) * 100.;
-    return { function, pctOfTotalExecutionTime, totalDuration, timesCalled };
+TimeExecStatistics::SummaryRowType
+TimeExecStatistics::getFunctionSummary(const CallSite *callSite) {
+    const RequestSummary &summary = statistic.at(callSite);
+    double pctOfTotalExecutionTime =
+        maxDurationMs > 0 ? (summary.totalDurationMs / maxDurationMs) * 100. : 0;
+    return { callSite, pctOfTotalExecutionTime, summary.totalDurationMs, summary.count };
 }
 
 void TimeExecStatistics::printRowDelimiter(std::stringstream &ss,
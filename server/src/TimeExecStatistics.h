@@ -1,48 +1,114 @@
 #ifndef UNITTESTBOT_TIMEEXECSTATISTICS_H
 #define UNITTESTBOT_TIMEEXECSTATISTICS_H
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <string>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 #include "utils/path/FileSystemPath.h"
 
 // add this macro to the beginning of the function
-#define MEASURE_FUNCTION_EXECUTION_TIME const TimeExecStatistics timeExecStats(__FILE__, __FUNCTION__, __LINE__);
-
+#define MEASURE_FUNCTION_EXECUTION_TIME                                                            \
+    static TimeExecStatistics::CallSite timeExecCallSite(__FILE__, __FUNCTION__, __LINE__);       \
+    const TimeExecStatistics timeExecStats(timeExecCallSite);
+
+/**
+ * Measures execution time of a scope (span).
+ *
+ * Every call site keeps server-wide totals and a fixed-size histogram of its durations,
+ * they are exported by GetMetrics. Durations of the current request are summarized per call
+ * site on the request thread and printed by printStatistic(). If tracing is enabled
+ * (`--trace`), spans of the request, including ones of its worker threads and child
+ * processes, are saved as a Chrome trace-event JSON file, see Paths::getTracePath.
+ */
 class TimeExecStatistics {
 public:
-    TimeExecStatistics(const fs::path &file, const std::string &function, uint32_t line);
+    /**
+     * Durations in [2^(i-1), 2^i) milliseconds go to bucket i, shorter than 1 ms to bucket 0,
+     * longer ones to the last one.
+     */
+    static constexpr size_t HISTOGRAM_BUCKETS = 24;
 
-    ~TimeExecStatistics();
+    struct CallSite {
+        CallSite(const fs::path &file, std::string function, uint32_t line);
 
-    struct Caller {
-        std::string file, function;
+        CallSite(const CallSite &) = delete;
+        CallSite &operator=(const CallSite &) = delete;
 
-        Caller(std::string file, std::string function);
+        const std::string file, function;
 
-        [[nodiscard]] std::string get() const;
+        std::atomic<uint64_t> count = 0;
+        std::atomic<uint64_t> totalMicroseconds = 0;
+        std::atomic<uint64_t> maxMicroseconds = 0;
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> histogram{};
 
-        bool operator==(const Caller &other) const;
+        [[nodiscard]] std::string get() const;
 
-        friend std::ostream& operator<<(std::ostream &os, const Caller &caller);
+        void record(uint64_t microseconds);
     };
 
-    struct CallerHash {
-        std::size_t operator()(const Caller &caller) const;
-    };
+    class Trace;
+
+    /**
+     * @param traceName name of the span in the trace, call site function by default.
+     */
+    explicit TimeExecStatistics(CallSite &callSite, std::string traceName = "");
+
+    ~TimeExecStatistics();
 
+    /**
+     * @brief Starts statistics (and the trace, if enabled) of a new request on this thread.
+     */
     static void clearStatistic();
 
+    /**
+     * @brief Prints statistics of the request and saves its trace.
+     */
     static void printStatistic();
 
+    /**
+     * @return call site of child processes running the given executable.
+     */
+    static CallSite &getProcessCallSite(const fs::path &executable);
+
+    /**
+     * @return all call sites executed since the server start.
+     */
+    static std::vector<const CallSite *> getCallSites();
+
+    /**
+     * Trace of the request handled by the current thread, worker threads have to share it.
+     */
+    static std::shared_ptr<Trace> getTrace();
+
+    static void setTrace(std::shared_ptr<Trace> trace);
+
+    /**
+     * Starts statistics of a request on this thread and drops them when the request ends, even
+     * if it throws before printStatistic(), so the trace doesn't outlive the request.
+     */
+    class RequestScope {
+    public:
+        RequestScope();
+
+        ~RequestScope();
+
+        RequestScope(const RequestScope &) = delete;
+        RequestScope &operator=(const RequestScope &) = delete;
+    };
+
 private:
+    CallSite &callSite;
+    const std::string traceName;
     const std::chrono::steady_clock::time_point begin;
-    const Caller currentCaller;
 
-    using SummaryRowType = std::tuple<Caller, double, uint64_t, uint64_t>;
+    using SummaryRowType = std::tuple<const CallSite *, double, uint64_t, uint64_t>;
 
-    static SummaryRowType getFunctionSummary(const Caller &function);
+    static SummaryRowType getFunctionSummary(const CallSite *callSite);
 
     static void printRowDelimiter(std::stringstream &ss, const std::vector<size_t> &columnsWidth);
 
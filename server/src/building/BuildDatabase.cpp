@@ -14,6 +14,7 @@
 #include "loguru.h"
 
 #include <functional>
+#include <mutex>
 #include <queue>
 #include <unordered_map>
 #include <utility>
@@ -75,6 +76,10 @@ void BuildDatabase::createClangCompileCommandsJson() {
     }
 
     fs::path clangCompileCommandsJsonPath = CompilationUtils::getClangCompileCommandsJsonPath(buildCommandsJsonPath);
+    // project and target databases of concurrent requests share the file, so nobody may
+    // rewrite it between writing and loading
+    static std::mutex clangCompileCommandsJsonMutex;
+    std::lock_guard<std::mutex> lock(clangCompileCommandsJsonMutex);
     JsonUtils::writeJsonToFile(clangCompileCommandsJsonPath, compileCommandsSingleFilesJson);
     compilationDatabase = CompilationUtils::getCompilationDatabase(clangCompileCommandsJsonPath);
 }
@@ -7,14 +7,225 @@
 
 #include <llvm/BinaryFormat/Magic.h>
 #include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
 #include <llvm/IR/Metadata.h>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/ErrorOr.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/MD5.h>
 #include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include <PathSubstitution.h>
 
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+    template <typename T>
+    std::string printToString(const T &value) {
+        std::string result;
+        llvm::raw_string_ostream stream(result);
+        value.print(stream);
+        return stream.str();
+    }
+
+    class FingerprintBuilder {
+    public:
+        void addType(llvm::Type *type) {
+            hash.update(printToString(*type));
+            // named structs are printed by name only, so their bodies are hashed explicitly
+            if (!visitedTypes.insert(type).second) {
+                return;
+            }
+            for (llvm::Type *subtype : type->subtypes()) {
+                addType(subtype);
+            }
+        }
+
+        void addString(llvm::StringRef value) {
+            hash.update(value);
+            hash.update(llvm::StringRef("\0", 1));
+        }
+
+        void addNumber(uint64_t value) {
+            addString(std::to_string(value));
+        }
+
+        void addAttributes(const llvm::AttributeList &attributes) {
+            for (unsigned index = attributes.index_begin(); index != attributes.index_end(); ++index) {
+                addString(attributes.getAsString(index));
+            }
+        }
+
+        void addFunction(const llvm::Function &function) {
+            addString(function.getName());
+            addType(function.getFunctionType());
+            addNumber(function.getLinkage());
+            addNumber(function.getCallingConv());
+            addAttributes(function.getAttributes());
+            if (function.isDeclaration()) {
+                addString("declare");
+                return;
+            }
+            std::unordered_map<const llvm::Value *, size_t> localIds;
+            for (const auto &argument : function.args()) {
+                localIds.emplace(&argument, localIds.size());
+            }
+            for (const auto &block : function) {
+                localIds.emplace(&block, localIds.size());
+                for (const auto &instruction : block) {
+                    localIds.emplace(&instruction, localIds.size());
+                }
+            }
+            for (const auto &instruction : llvm::instructions(function)) {
+                if (llvm::isa<llvm::DbgInfoIntrinsic>(instruction)) {
+                    continue;
+                }
+                addString(instruction.getOpcodeName());
+                addType(instruction.getType());
+                // nsw, nuw, exact, inbounds and fast-math flags
+                addNumber(instruction.getRawSubclassOptionalData());
+                addInstructionDetails(instruction, localIds);
+                for (const llvm::Use &operand : instruction.operands()) {
+                    addOperand(operand.get(), localIds);
+                }
+                addDebugLocation(instruction.getDebugLoc().get());
+            }
+        }
+
+        void addGlobal(const llvm::GlobalVariable &global) {
+            addString(global.getName());
+            addType(global.getValueType());
+            addString(global.isConstant() ? "constant" : "global");
+            if (global.hasInitializer()) {
+                addString(printToString(*global.getInitializer()));
+            }
+        }
+
+        std::string getResult() {
+            llvm::MD5::MD5Result result;
+            hash.final(result);
+            return result.digest().str().str();
+        }
+
+    private:
+        /**
+         * Adds properties of the instruction which aren't its operands.
+         */
+        void addInstructionDetails(const llvm::Instruction &instruction,
+                                   const std::unordered_map<const llvm::Value *, size_t> &localIds) {
+            if (const auto *cmp = llvm::dyn_cast<llvm::CmpInst>(&instruction)) {
+                addString(llvm::CmpInst::getPredicateName(cmp->getPredicate()));
+            } else if (const auto *alloca = llvm::dyn_cast<llvm::AllocaInst>(&instruction)) {
+                addType(alloca->getAllocatedType());
+                addNumber(alloca->getAlignment());
+            } else if (const auto *gep = llvm::dyn_cast<llvm::GetElementPtrInst>(&instruction)) {
+                addType(gep->getSourceElementType());
+            } else if (const auto *load = llvm::dyn_cast<llvm::LoadInst>(&instruction)) {
+                addNumber(load->isVolatile());
+                addNumber(load->getAlignment());
+                addNumber(static_cast<uint64_t>(load->getOrdering()));
+                addNumber(load->getSyncScopeID());
+            } else if (const auto *store = llvm::dyn_cast<llvm::StoreInst>(&instruction)) {
+                addNumber(store->isVolatile());
+                addNumber(store->getAlignment());
+                addNumber(static_cast<uint64_t>(store->getOrdering()));
+                addNumber(store->getSyncScopeID());
+            } else if (const auto *rmw = llvm::dyn_cast<llvm::AtomicRMWInst>(&instruction)) {
+                addNumber(rmw->getOperation());
+                addNumber(rmw->isVolatile());
+                addNumber(static_cast<uint64_t>(rmw->getOrdering()));
+                addNumber(rmw->getSyncScopeID());
+            } else if (const auto *cmpXchg = llvm::dyn_cast<llvm::AtomicCmpXchgInst>(&instruction)) {
+                addNumber(cmpXchg->isVolatile());
+                addNumber(cmpXchg->isWeak());
+                addNumber(static_cast<uint64_t>(cmpXchg->getSuccessOrdering()));
+                addNumber(static_cast<uint64_t>(cmpXchg->getFailureOrdering()));
+                addNumber(cmpXchg->getSyncScopeID());
+            } else if (const auto *fence = llvm::dyn_cast<llvm::FenceInst>(&instruction)) {
+                addNumber(static_cast<uint64_t>(fence->getOrdering()));
+                addNumber(fence->getSyncScopeID());
+            } else if (const auto *phi = llvm::dyn_cast<llvm::PHINode>(&instruction)) {
+                // incoming blocks aren't operands of the instruction
+                for (const llvm::BasicBlock *block : phi->blocks()) {
+                    addOperand(block, localIds);
+                }
+            } else if (const auto *extract = llvm::dyn_cast<llvm::ExtractValueInst>(&instruction)) {
+                for (unsigned index : extract->getIndices()) {
+                    addNumber(index);
+                }
+            } else if (const auto *insert = llvm::dyn_cast<llvm::InsertValueInst>(&instruction)) {
+                for (unsigned index : insert->getIndices()) {
+                    addNumber(index);
+                }
+            } else if (const auto *shuffle = llvm::dyn_cast<llvm::ShuffleVectorInst>(&instruction)) {
+                llvm::SmallVector<int, 16> mask;
+                shuffle->getShuffleMask(mask);
+                for (int element : mask) {
+                    addString(std::to_string(element));
+                }
+            } else if (const auto *call = llvm::dyn_cast<llvm::CallBase>(&instruction)) {
+                addNumber(call->getCallingConv());
+                addAttributes(call->getAttributes());
+                if (const auto *callInst = llvm::dyn_cast<llvm::CallInst>(call)) {
+                    addNumber(callInst->getTailCallKind());
+                }
+            }
+        }
+
+        /**
+         * Adds source location of the instruction, KLEE reports it in error descriptors of
+         * ktests, so they can't be reused if the code moves in the source file.
+         */
+        void addDebugLocation(const llvm::DILocation *location) {
+            for (; location != nullptr; location = location->getInlinedAt()) {
+                addString(location->getDirectory());
+                addString(location->getFilename());
+                addNumber(location->getLine());
+                addNumber(location->getColumn());
+            }
+            addString("");
+        }
+
+        void addOperand(const llvm::Value *operand,
+                        const std::unordered_map<const llvm::Value *, size_t> &localIds) {
+            if (auto it = localIds.find(operand); it != localIds.end()) {
+                addString("%" + std::to_string(it->second));
+            } else if (const auto *global = llvm::dyn_cast<llvm::GlobalValue>(operand)) {
+                addString("@" + global->getName().str());
+            } else if (llvm::isa<llvm::MetadataAsValue>(operand)) {
+                addString("!");
+            } else {
+                addString(printToString(*operand));
+            }
+        }
+
+        llvm::MD5 hash;
+        std::unordered_set<llvm::Type *> visitedTypes;
+    };
+
+    void collectReferencedGlobals(const llvm::Value *value,
+                                  std::vector<const llvm::GlobalValue *> &worklist,
+                                  std::unordered_set<const llvm::Value *> &visited) {
+        if (!visited.insert(value).second) {
+            return;
+        }
+        if (const auto *global = llvm::dyn_cast<llvm::GlobalValue>(value)) {
+            worklist.push_back(global);
+            return;
+        }
+        if (const auto *constant = llvm::dyn_cast<llvm::Constant>(value)) {
+            for (const llvm::Use &operand : constant->operands()) {
+                collectReferencedGlobals(operand.get(), worklist, visited);
+            }
+        }
+    }
+}
+
 bool IRParser::parseModule(const fs::path &rootBitcode, tests::TestsMap &tests) {
     try {
         LOG_S(DEBUG) << "Parse module: " << rootBitcode.c_str();
@@ -30,7 +241,7 @@ bool IRParser::parseModule(const fs::path &rootBitcode, tests::TestsMap &tests)
                     std::string methodDebugInfo =
                         StringUtils::stringFormat("Method: '%s', file: '%s'", methodName, sourceFile);
                     if (llvm::Function *pFunction = module->getFunction(entryPointFunction)) {
-                        continue;
+                        test.methods[methodName].irFingerprint = getFingerprint(*module, *pFunction);
                     } else {
                         LOG_S(DEBUG) << "llvm::Function is null: " << methodDebugInfo;
                         test.isFilePresentedInArtifact = false;
@@ -91,3 +302,43 @@ std::unique_ptr<llvm::Module> IRParser::getModule(const fs::path &rootBitcode,
     }
     return nullptr;
 }
+
+std::string IRParser::getFingerprint(const llvm::Module &module, const llvm::Function &entryPoint) {
+    std::vector<const llvm::GlobalValue *> worklist{ &entryPoint };
+    std::unordered_set<const llvm::Value *> visited{ &entryPoint };
+    std::map<std::string, const llvm::Function *> functions;
+    std::map<std::string, const llvm::GlobalVariable *> globals;
+    while (!worklist.empty()) {
+        const llvm::GlobalValue *value = worklist.back();
+        worklist.pop_back();
+        if (const auto *function = llvm::dyn_cast<llvm::Function>(value)) {
+            functions.emplace(function->getName().str(), function);
+            for (const auto &instruction : llvm::instructions(*function)) {
+                if (llvm::isa<llvm::DbgInfoIntrinsic>(instruction)) {
+                    continue;
+                }
+                for (const llvm::Use &operand : instruction.operands()) {
+                    collectReferencedGlobals(operand.get(), worklist, visited);
+                }
+            }
+        } else if (const auto *global = llvm::dyn_cast<llvm::GlobalVariable>(value)) {
+            globals.emplace(global->getName().str(), global);
+            if (global->hasInitializer()) {
+                collectReferencedGlobals(global->getInitializer(), worklist, visited);
+            }
+        } else if (const auto *alias = llvm::dyn_cast<llvm::GlobalAlias>(value)) {
+            collectReferencedGlobals(alias->getAliasee(), worklist, visited);
+        }
+    }
+
+    FingerprintBuilder builder;
+    builder.addString(module.getTargetTriple());
+    builder.addString(module.getDataLayoutStr());
+    for (const auto &[name, function] : functions) {
+        builder.addFunction(*function);
+    }
+    for (const auto &[name, global] : globals) {
+        builder.addGlobal(*global);
+    }
+    return builder.getResult();
+}
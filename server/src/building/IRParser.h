@@ -10,11 +10,23 @@
 
 class IRParser {
 public:
+    /**
+     * @brief Checks that entrypoints of all methods are present in the module and computes
+     * their IR fingerprints.
+     *
+     * Fingerprint of the method is a hash of its entrypoint together with all functions and
+     * globals reachable from it (stubs included) and the layout of the types they use. Debug
+     * info is ignored except for source locations of instructions, so the fingerprint changes
+     * only if KLEE may explore the method in a different way or report its errors at other
+     * lines.
+     */
     bool parseModule(const fs::path &rootBitcode, tests::TestsMap &tests);
 
 private:
     std::unique_ptr<llvm::Module> getModule(const fs::path &rootBitcode,
                                             llvm::LLVMContext &context);
+
+    static std::string getFingerprint(const llvm::Module &module, const llvm::Function &entryPoint);
 };
 
 
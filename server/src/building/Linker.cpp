@@ -400,13 +400,18 @@ Result<Linker::LinkResult> Linker::link(const CollectionUtils::MapFileTo<fs::pat
 
     testMakefilesPrinter.addLinkTargetRecursively(target, suffixForParentOfStubs);
 
+    std::vector<fs::path> testedSources;
     for (auto const &[objectFile, _] : bitcodeFiles) {
         auto compilationUnitInfo = testGen.getClientCompilationUnitInfo(objectFile);
         auto sourcePath = compilationUnitInfo->getSourcePath();
         if (CollectionUtils::containsKey(testGen.tests, sourcePath)) {
-            testMakefilesPrinter.GetMakefiles(sourcePath).write();
+            testedSources.push_back(sourcePath);
         }
     }
+    testMakefilesPrinter.addUnityGroups(testedSources);
+    for (auto const &sourcePath : testedSources) {
+        testMakefilesPrinter.GetMakefiles(sourcePath).write();
+    }
     return LinkResult{ targetBitcode, stubsSet, presentedFiles };
 };
 
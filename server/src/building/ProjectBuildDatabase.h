@@ -20,6 +20,14 @@ public:
                          utbot::ProjectContext projectContext);
 
     ProjectBuildDatabase(utbot::ProjectContext projectContext);
+
+    /**
+     * @brief Copies the database, object file infos are copied deeply.
+     *
+     * Object file infos hold klee files state filled by a request, so a database shared by
+     * requests is never used directly, each request gets its own copy.
+     */
+    ProjectBuildDatabase(const ProjectBuildDatabase &other);
 };
 
 
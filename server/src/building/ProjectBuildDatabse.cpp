@@ -56,6 +56,27 @@ ProjectBuildDatabase::ProjectBuildDatabase(utbot::ProjectContext projectContext)
         Paths::getUTBotBuildDir(projectContext), std::move(projectContext)) {
 }
 
+ProjectBuildDatabase::ProjectBuildDatabase(const ProjectBuildDatabase &other) : BuildDatabase(other) {
+    std::unordered_map<const ObjectFileInfo *, std::shared_ptr<ObjectFileInfo>> copies;
+    auto copy = [&copies](std::shared_ptr<ObjectFileInfo> &objectInfo) {
+        auto &copied = copies[objectInfo.get()];
+        if (copied == nullptr) {
+            copied = std::make_shared<ObjectFileInfo>(*objectInfo);
+            if (objectInfo->kleeFilesInfo != nullptr) {
+                copied->kleeFilesInfo = std::make_shared<KleeFilesInfo>(*objectInfo->kleeFilesInfo);
+            }
+        }
+        objectInfo = copied;
+    };
+    for (auto &[_, objectInfos] : sourceFileInfos) {
+        for (auto &objectInfo : objectInfos) {
+            copy(objectInfo);
+        }
+    }
+    for (auto &[_, objectInfo] : objectFileInfos) {
+        copy(objectInfo);
+    }
+}
 
 void ProjectBuildDatabase::initObjects(const nlohmann::json &compileCommandsJson) {
     for (const nlohmann::json &compileCommand: compileCommandsJson) {
@@ -0,0 +1,112 @@
+#include "ProjectSessionCache.h"
+
+#include "Paths.h"
+#include "commands/Commands.h"
+#include "utils/CompilationUtils.h"
+
+#include "loguru.h"
+
+#include <algorithm>
+
+ProjectSessionCache &ProjectSessionCache::getInstance() {
+    // never destroyed: forked children call exit() while other threads may use the cache
+    static auto *instance = new ProjectSessionCache();
+    return *instance;
+}
+
+std::shared_ptr<ProjectBuildDatabase>
+ProjectSessionCache::getProjectBuildDatabase(const fs::path &buildCommandsJsonPath,
+                                             const fs::path &serverBuildDir,
+                                             const utbot::ProjectContext &projectContext) {
+    if (Commands::projectSessionCacheSize == 0) {
+        return std::make_shared<ProjectBuildDatabase>(buildCommandsJsonPath, serverBuildDir,
+                                                      projectContext);
+    }
+    return std::make_shared<ProjectBuildDatabase>(
+        *getSession(buildCommandsJsonPath, serverBuildDir, projectContext));
+}
+
+std::shared_ptr<ProjectBuildDatabase>
+ProjectSessionCache::getProjectBuildDatabase(const utbot::ProjectContext &projectContext) {
+    return getProjectBuildDatabase(
+        CompilationUtils::substituteRemotePathToCompileCommandsJsonPath(projectContext),
+        Paths::getUTBotBuildDir(projectContext), projectContext);
+}
+
+std::shared_ptr<const ProjectBuildDatabase>
+ProjectSessionCache::getSnapshot(const utbot::ProjectContext &projectContext) {
+    return getSession(CompilationUtils::substituteRemotePathToCompileCommandsJsonPath(projectContext),
+                      Paths::getUTBotBuildDir(projectContext), projectContext);
+}
+
+std::shared_ptr<const ProjectBuildDatabase>
+ProjectSessionCache::getSession(const fs::path &buildCommandsJsonPath,
+                                const fs::path &serverBuildDir,
+                                const utbot::ProjectContext &projectContext) {
+    // build database is never shared when the cache is disabled
+    if (Commands::projectSessionCacheSize == 0) {
+        return std::make_shared<const ProjectBuildDatabase>(buildCommandsJsonPath, serverBuildDir,
+                                                            projectContext);
+    }
+    std::string key = projectContext.projectPath.string();
+    for (const fs::path &path : { projectContext.buildDirRelativePath, buildCommandsJsonPath,
+                                  serverBuildDir, projectContext.testDirPath }) {
+        key += '\0';
+        key += path.string();
+    }
+    std::vector<FileStamp> stamps = getStamps(buildCommandsJsonPath);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(sessions.begin(), sessions.end(),
+                               [&key](const Session &session) { return session.key == key; });
+        if (it != sessions.end()) {
+            if (it->stamps == stamps) {
+                sessions.splice(sessions.begin(), sessions, it);
+                LOG_S(DEBUG) << "Build database of " << projectContext.projectName
+                             << " is taken from the session cache";
+                return it->buildDatabase;
+            }
+            totalJsonSize -= it->jsonSize;
+            sessions.erase(it);
+        }
+    }
+
+    // database is built out of the lock, so requests for other projects don't wait for it
+    auto buildDatabase = std::make_shared<const ProjectBuildDatabase>(
+        buildCommandsJsonPath, serverBuildDir, projectContext);
+    std::uintmax_t jsonSize = 0;
+    for (const auto &[modificationTime, size] : stamps) {
+        jsonSize += size;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(sessions.begin(), sessions.end(),
+                               [&key](const Session &session) { return session.key == key; });
+        if (it != sessions.end()) {
+            totalJsonSize -= it->jsonSize;
+            sessions.erase(it);
+        }
+        sessions.push_front({ key, std::move(stamps), buildDatabase, jsonSize });
+        totalJsonSize += jsonSize;
+        std::uintmax_t memoryLimit = static_cast<std::uintmax_t>(Commands::projectSessionCacheMemory) << 20;
+        while (sessions.size() > Commands::projectSessionCacheSize ||
+               (sessions.size() > 1 && totalJsonSize > memoryLimit)) {
+            totalJsonSize -= sessions.back().jsonSize;
+            sessions.pop_back();
+        }
+    }
+    return buildDatabase;
+}
+
+std::vector<ProjectSessionCache::FileStamp>
+ProjectSessionCache::getStamps(const fs::path &buildCommandsJsonPath) {
+    std::vector<FileStamp> stamps;
+    for (const std::string &fileName : { "link_commands.json", "compile_commands.json" }) {
+        fs::path path = buildCommandsJsonPath / fileName;
+        std::error_code errorCode;
+        auto modificationTime = fs::last_write_time(path, errorCode);
+        auto size = fs::file_size(path, errorCode);
+        stamps.emplace_back(modificationTime, errorCode ? 0 : size);
+    }
+    return stamps;
+}
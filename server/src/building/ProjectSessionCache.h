@@ -0,0 +1,84 @@
+#ifndef UNITTESTBOT_PROJECTSESSIONCACHE_H
+#define UNITTESTBOT_PROJECTSESSIONCACHE_H
+
+#include "ProjectBuildDatabase.h"
+#include "ProjectContext.h"
+
+#include "utils/path/FileSystemPath.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Server-wide cache of project state kept in memory between requests.
+ *
+ * Building ProjectBuildDatabase parses link_commands.json and compile_commands.json and
+ * checks every path in them on disk, which dominates cold start of requests for a single
+ * function or line. A session keeps the parsed database of a project and hands out copies
+ * of it. The session is dropped once any of the JSON files changes. At most
+ * `--project-session-cache-size` least recently used sessions are kept. A parsed database
+ * holds the paths and flags of its JSON files, so its memory follows their size, and the
+ * total size of the JSON files of all sessions is kept under
+ * `--project-session-cache-memory`; the most recent session is kept anyway.
+ *
+ * Only build databases are kept. Fetched declarations and type maps depend on the content of
+ * every source and header, and the types handler which uses them isn't thread-safe, so they
+ * can't be shared without tracking all included files and copying the maps. Bitcode files
+ * and linked modules are already reused from disk by incremental make.
+ *
+ * Cached databases are immutable snapshots: a changed project gets a new snapshot instead of
+ * updating the old one, so read-only requests may use a snapshot without any request lock
+ * while generation for the same project is running.
+ */
+class ProjectSessionCache {
+public:
+    static ProjectSessionCache &getInstance();
+
+    /**
+     * @return own copy of the project build database, so requests don't share klee files state.
+     * @throws CompilationDatabaseException if the database can't be built.
+     */
+    std::shared_ptr<ProjectBuildDatabase> getProjectBuildDatabase(const fs::path &buildCommandsJsonPath,
+                                                                  const fs::path &serverBuildDir,
+                                                                  const utbot::ProjectContext &projectContext);
+
+    std::shared_ptr<ProjectBuildDatabase> getProjectBuildDatabase(const utbot::ProjectContext &projectContext);
+
+    /**
+     * @return shared immutable database for requests that only read it.
+     * @throws CompilationDatabaseException if the database can't be built.
+     */
+    std::shared_ptr<const ProjectBuildDatabase> getSnapshot(const utbot::ProjectContext &projectContext);
+
+private:
+    using FileStamp = std::pair<fs::file_time_type, std::uintmax_t>;
+
+    struct Session {
+        std::string key;
+        std::vector<FileStamp> stamps;
+        std::shared_ptr<const ProjectBuildDatabase> buildDatabase;
+        std::uintmax_t jsonSize;
+    };
+
+    ProjectSessionCache() = default;
+
+    std::shared_ptr<const ProjectBuildDatabase> getSession(const fs::path &buildCommandsJsonPath,
+                                                           const fs::path &serverBuildDir,
+                                                           const utbot::ProjectContext &projectContext);
+
+    static std::vector<FileStamp> getStamps(const fs::path &buildCommandsJsonPath);
+
+    std::mutex mutex;
+    /**
+     * Most recently used sessions go first.
+     */
+    std::list<Session> sessions;
+    std::uintmax_t totalJsonSize = 0;
+};
+
+
+#endif // UNITTESTBOT_PROJECTSESSIONCACHE_H
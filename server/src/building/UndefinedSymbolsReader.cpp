@@ -0,0 +1,137 @@
+#include "UndefinedSymbolsReader.h"
+
+#include "utils/StringUtils.h"
+
+#include "loguru.h"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Object/Archive.h>
+#include <llvm/Object/Binary.h>
+#include <llvm/Support/Casting.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <string_view>
+
+UndefinedSymbolsReader &UndefinedSymbolsReader::getInstance() {
+    // never destroyed: forked children call exit() while other threads may read symbols
+    static auto *instance = new UndefinedSymbolsReader();
+    return *instance;
+}
+
+Result<std::vector<std::string>> UndefinedSymbolsReader::read(const fs::path &objectFilePath) {
+    std::error_code errorCode;
+    auto modificationTime = fs::last_write_time(objectFilePath, errorCode);
+    if (errorCode) {
+        return StringUtils::stringFormat("Couldn't access %s: %s", objectFilePath,
+                                         errorCode.message());
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(objectFilePath);
+        if (it != cache.end() && it->second->modificationTime == modificationTime) {
+            return use(it->second).symbols;
+        }
+    }
+
+    auto buffer = llvm::MemoryBuffer::getFile(objectFilePath.string(), -1, false);
+    if (!buffer) {
+        return StringUtils::stringFormat("Couldn't read %s: %s", objectFilePath,
+                                         buffer.getError().message());
+    }
+    llvm::StringRef content = buffer.get()->getBuffer();
+    std::size_t contentHash =
+        std::hash<std::string_view>()(std::string_view(content.data(), content.size()));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(objectFilePath);
+        if (it != cache.end() && it->second->contentHash == contentHash) {
+            it->second->modificationTime = modificationTime;
+            return use(it->second).symbols;
+        }
+    }
+
+    auto result = parse(objectFilePath, buffer.get()->getMemBufferRef());
+    if (result.isSuccess()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(objectFilePath);
+        if (it != cache.end()) {
+            cachedSymbolsCount -= it->second->symbols.size();
+            entries.erase(it->second);
+        }
+        entries.push_front({ objectFilePath, modificationTime, contentHash, result.getOpt().value() });
+        cache[objectFilePath] = entries.begin();
+        cachedSymbolsCount += entries.front().symbols.size();
+        // the file just read is kept anyway
+        while (entries.size() > 1 && cachedSymbolsCount > MAX_CACHED_SYMBOLS) {
+            cachedSymbolsCount -= entries.back().symbols.size();
+            cache.erase(entries.back().path);
+            entries.pop_back();
+        }
+    }
+    return result;
+}
+
+const UndefinedSymbolsReader::CachedSymbols &
+UndefinedSymbolsReader::use(std::list<CachedSymbols>::iterator it) {
+    entries.splice(entries.begin(), entries, it);
+    return *it;
+}
+
+Result<std::vector<std::string>> UndefinedSymbolsReader::parse(const fs::path &objectFilePath,
+                                                               llvm::MemoryBufferRef buffer) {
+    LOG_SCOPE_FUNCTION(DEBUG);
+    // bitcode files are parsed into modules owned by the context
+    llvm::LLVMContext context;
+    auto binary = llvm::object::createBinary(buffer, &context);
+    if (!binary) {
+        return StringUtils::stringFormat("Couldn't parse %s: %s", objectFilePath,
+                                         llvm::toString(binary.takeError()));
+    }
+    std::vector<std::string> symbols;
+    if (auto *archive = llvm::dyn_cast<llvm::object::Archive>(binary->get())) {
+        llvm::Error error = llvm::Error::success();
+        for (const auto &child : archive->children(error)) {
+            auto childBinary = child.getAsBinary(&context);
+            if (!childBinary) {
+                // members which are not object files are skipped as llvm-nm does
+                llvm::consumeError(childBinary.takeError());
+                continue;
+            }
+            if (auto *symbolicFile = llvm::dyn_cast<llvm::object::SymbolicFile>(childBinary->get())) {
+                addUndefinedSymbols(*symbolicFile, symbols);
+            }
+        }
+        if (error) {
+            return StringUtils::stringFormat("Couldn't read members of %s: %s", objectFilePath,
+                                             llvm::toString(std::move(error)));
+        }
+    } else if (auto *symbolicFile = llvm::dyn_cast<llvm::object::SymbolicFile>(binary->get())) {
+        addUndefinedSymbols(*symbolicFile, symbols);
+    } else {
+        return StringUtils::stringFormat("%s is not an object file", objectFilePath);
+    }
+    return symbols;
+}
+
+void UndefinedSymbolsReader::addUndefinedSymbols(const llvm::object::SymbolicFile &symbolicFile,
+                                                 std::vector<std::string> &symbols) {
+    for (const auto &symbol : symbolicFile.symbols()) {
+        uint32_t flags = symbol.getFlags();
+        if (!(flags & llvm::object::SymbolRef::SF_Undefined) ||
+            (flags & llvm::object::SymbolRef::SF_FormatSpecific)) {
+            continue;
+        }
+        std::string name;
+        llvm::raw_string_ostream nameStream(name);
+        if (llvm::Error error = symbol.printName(nameStream)) {
+            llvm::consumeError(std::move(error));
+            continue;
+        }
+        nameStream.flush();
+        if (!name.empty()) {
+            symbols.push_back(std::move(name));
+        }
+    }
+}
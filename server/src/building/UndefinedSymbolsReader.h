@@ -0,0 +1,71 @@
+#ifndef UNITTESTBOT_UNDEFINEDSYMBOLSREADER_H
+#define UNITTESTBOT_UNDEFINEDSYMBOLSREADER_H
+
+#include "Result.h"
+#include "utils/HashUtils.h"
+#include "utils/path/FileSystemPath.h"
+
+#include <llvm/Object/SymbolicFile.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Reads undefined symbols of object files, bitcode files and archives of them in-process,
+ * the same way `llvm-nm --undefined-only` does.
+ *
+ * Results are kept in a server-wide cache. An entry is reused while the modification time of
+ * the file is unchanged; otherwise the file is read again and reparsed only if its content
+ * hash differs, so relinked but identical objects are not parsed twice. Symbols of the least
+ * recently read files are dropped once the cache holds more than MAX_CACHED_SYMBOLS of them.
+ */
+class UndefinedSymbolsReader {
+public:
+    static UndefinedSymbolsReader &getInstance();
+
+    /**
+     * @return undefined symbols of the file or error message if it can't be parsed.
+     */
+    Result<std::vector<std::string>> read(const fs::path &objectFilePath);
+
+    /**
+     * A few tens of megabytes of symbol names, enough for objects and libraries of large projects.
+     */
+    static constexpr size_t MAX_CACHED_SYMBOLS = 1 << 20;
+
+private:
+    struct CachedSymbols {
+        fs::path path;
+        fs::file_time_type modificationTime;
+        std::size_t contentHash;
+        std::vector<std::string> symbols;
+    };
+
+    UndefinedSymbolsReader() = default;
+
+    static Result<std::vector<std::string>> parse(const fs::path &objectFilePath,
+                                                  llvm::MemoryBufferRef buffer);
+
+    static void addUndefinedSymbols(const llvm::object::SymbolicFile &symbolicFile,
+                                    std::vector<std::string> &symbols);
+
+    /**
+     * @brief Makes the entry the most recently used one. Called under the mutex.
+     */
+    const CachedSymbols &use(std::list<CachedSymbols>::iterator it);
+
+    std::mutex mutex;
+    /**
+     * Most recently read files go first.
+     */
+    std::list<CachedSymbols> entries;
+    std::unordered_map<fs::path, std::list<CachedSymbols>::iterator, HashUtils::PathHash> cache;
+    size_t cachedSymbolsCount = 0;
+};
+
+
+#endif // UNITTESTBOT_UNDEFINEDSYMBOLSREADER_H
@@ -0,0 +1,171 @@
+#include "BitcodeCompiler.h"
+
+#include "tasks/JobScheduler.h"
+#include "utils/ExecUtils.h"
+#include "utils/StringUtils.h"
+
+#include "loguru.h"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/CodeGen/CodeGenAction.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
+#include <clang/Frontend/Utils.h>
+#include <llvm/Support/CrashRecoveryContext.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <vector>
+
+BitcodeCompiler::BitcodeCompiler() {
+    // installs handlers of crash signals, threads outside of RunSafely aren't affected
+    llvm::CrashRecoveryContext::Enable();
+}
+
+BitcodeCompiler &BitcodeCompiler::getInstance() {
+    // never destroyed: forked children call exit() while other threads may compile
+    static auto *instance = new BitcodeCompiler();
+    return *instance;
+}
+
+std::optional<Result<fs::path>> BitcodeCompiler::compile(const utbot::CompileCommand &command) {
+    LOG_SCOPE_FUNCTION(DEBUG);
+    ExecUtils::throwIfCancelled();
+    auto slot = JobScheduler::getInstance().acquire();
+    std::optional<Result<fs::path>> result;
+    std::string preambleKey;
+    llvm::CrashRecoveryContext crashRecoveryContext;
+    bool completed = crashRecoveryContext.RunSafely(
+        [&]() { result.emplace(compileUnsafe(command, preambleKey)); });
+    if (!completed) {
+        LOG_S(WARNING) << "Clang crashed while compiling " << command.getSourcePath()
+                       << " in-process";
+        // the preamble may be the cause, it must not break the following compilations
+        dropPreamble(preambleKey);
+        return std::nullopt;
+    }
+    ExecUtils::throwIfCancelled();
+    return result;
+}
+
+Result<fs::path> BitcodeCompiler::compileUnsafe(const utbot::CompileCommand &command,
+                                                std::string &preambleKey) {
+    std::vector<const char *> args;
+    for (const auto &arg : command.getCommandLine()) {
+        args.push_back(arg.c_str());
+    }
+
+    std::string diagnosticsText;
+    llvm::raw_string_ostream diagnosticsStream(diagnosticsText);
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> diagnosticOptions =
+            new clang::DiagnosticOptions();
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> diagnostics =
+            clang::CompilerInstance::createDiagnostics(
+                    diagnosticOptions.get(),
+                    new clang::TextDiagnosticPrinter(diagnosticsStream, diagnosticOptions.get()));
+
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> vfs =
+            llvm::vfs::createPhysicalFileSystem().release();
+    vfs->setCurrentWorkingDirectory(command.getDirectory().string());
+
+    std::shared_ptr<clang::CompilerInvocation> invocation =
+            clang::createInvocationFromCommandLine(args, diagnostics, vfs);
+    if (invocation == nullptr) {
+        diagnosticsStream.flush();
+        return StringUtils::stringFormat("Couldn't create compiler invocation for %s\n%s",
+                                         command.getSourcePath(), diagnosticsText);
+    }
+    invocation->getFileSystemOpts().WorkingDir = command.getDirectory().string();
+
+    std::string sourcePath = command.getSourcePath().string();
+    auto mainFileBuffer = vfs->getBufferForFile(sourcePath);
+    if (!mainFileBuffer) {
+        return StringUtils::stringFormat("Couldn't read %s: %s", sourcePath,
+                                         mainFileBuffer.getError().message());
+    }
+    auto bounds = clang::ComputePreambleBounds(*invocation->getLangOpts(),
+                                               mainFileBuffer->get(), 0);
+    // the same file compiled with the same flags is the only case the preamble can be reused in
+    preambleKey = command.getDirectory().string();
+    for (const char *arg : args) {
+        preambleKey += '\0';
+        preambleKey += arg;
+    }
+    auto preamble = getPreamble(preambleKey, *invocation, mainFileBuffer->get(), bounds, vfs);
+    if (preamble != nullptr) {
+        preamble->AddImplicitPreamble(*invocation, vfs, mainFileBuffer->get());
+    }
+
+    clang::CompilerInstance compiler;
+    compiler.setInvocation(std::move(invocation));
+    compiler.setDiagnostics(diagnostics.get());
+    compiler.createFileManager(vfs);
+    clang::EmitBCAction action;
+    bool success = compiler.ExecuteAction(action) && !diagnostics->hasErrorOccurred();
+    diagnosticsStream.flush();
+    if (!success) {
+        return diagnosticsText;
+    }
+    return command.getOutput();
+}
+
+std::shared_ptr<clang::PrecompiledPreamble>
+BitcodeCompiler::getPreamble(const std::string &key,
+                             const clang::CompilerInvocation &invocation,
+                             const llvm::MemoryBuffer *mainFileBuffer,
+                             const clang::PreambleBounds &bounds,
+                             llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> vfs) {
+    std::shared_ptr<clang::PrecompiledPreamble> cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(preambles.begin(), preambles.end(),
+                               [&key](const CachedPreamble &entry) { return entry.key == key; });
+        if (it != preambles.end()) {
+            cached = it->preamble;
+        }
+    }
+    // includes or headers themselves may have been changed since the preamble was built;
+    // checked without the lock, so a crash in clang doesn't leave the mutex locked
+    if (cached != nullptr && cached->CanReuse(invocation, mainFileBuffer, bounds, vfs.get())) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(preambles.begin(), preambles.end(),
+                               [&cached](const CachedPreamble &entry) { return entry.preamble == cached; });
+        if (it != preambles.end()) {
+            preambles.splice(preambles.begin(), preambles, it);
+        }
+        return cached;
+    }
+
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> diagnosticOptions =
+            new clang::DiagnosticOptions();
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> diagnostics =
+            clang::CompilerInstance::createDiagnostics(diagnosticOptions.get(),
+                                                       new clang::IgnoringDiagConsumer());
+    clang::PreambleCallbacks callbacks;
+    auto preamble = clang::PrecompiledPreamble::Build(
+            invocation, mainFileBuffer, bounds, *diagnostics, vfs,
+            std::make_shared<clang::PCHContainerOperations>(), false, callbacks);
+    if (!preamble) {
+        LOG_S(DEBUG) << "Preamble is not built: " << preamble.getError().message();
+        return nullptr;
+    }
+    if (diagnostics->hasErrorOccurred()) {
+        // errors are reported by the compilation itself, the preamble is useless
+        return nullptr;
+    }
+
+    auto built = std::make_shared<clang::PrecompiledPreamble>(std::move(preamble.get()));
+    std::lock_guard<std::mutex> lock(mutex);
+    preambles.remove_if([&key](const CachedPreamble &cached) { return cached.key == key; });
+    preambles.push_front({ key, built });
+    if (preambles.size() > PREAMBLE_CACHE_SIZE) {
+        preambles.pop_back();
+    }
+    return built;
+}
+
+void BitcodeCompiler::dropPreamble(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    preambles.remove_if([&key](const CachedPreamble &cached) { return cached.key == key; });
+}
@@ -0,0 +1,71 @@
+#ifndef UNITTESTBOT_BITCODECOMPILER_H
+#define UNITTESTBOT_BITCODECOMPILER_H
+
+#include "Result.h"
+#include "building/CompileCommand.h"
+#include "utils/path/FileSystemPath.h"
+
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/PrecompiledPreamble.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+/**
+ * Compiles generated klee files to bitcode inside the server process.
+ *
+ * Klee files include the same project headers as their sources, so most of the compilation
+ * time is spent on parsing the headers. The leading block of includes (preamble) is
+ * precompiled once and kept in a server-wide cache, so subsequent compilations of the same
+ * file, either retries after errors or following requests, parse only the generated code.
+ *
+ * A crash of the frontend is recovered from, so a broken file can't take the server down.
+ */
+class BitcodeCompiler {
+public:
+    static BitcodeCompiler &getInstance();
+
+    /**
+     * @brief Runs clang frontend for the command in-process in a job slot.
+     * @return path to the output bitcode or compiler diagnostics if compilation fails,
+     * std::nullopt if the frontend crashed, then the command has to be run in a separate process.
+     * @throws CancellationException if the request is cancelled.
+     */
+    std::optional<Result<fs::path>> compile(const utbot::CompileCommand &command);
+
+private:
+    struct CachedPreamble {
+        std::string key;
+        std::shared_ptr<clang::PrecompiledPreamble> preamble;
+    };
+
+    BitcodeCompiler();
+
+    /**
+     * @param preambleKey set to the key of the preamble used by the compilation.
+     */
+    Result<fs::path> compileUnsafe(const utbot::CompileCommand &command, std::string &preambleKey);
+
+    std::shared_ptr<clang::PrecompiledPreamble>
+    getPreamble(const std::string &key,
+                const clang::CompilerInvocation &invocation,
+                const llvm::MemoryBuffer *mainFileBuffer,
+                const clang::PreambleBounds &bounds,
+                llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> vfs);
+
+    void dropPreamble(const std::string &key);
+
+    static constexpr size_t PREAMBLE_CACHE_SIZE = 16;
+
+    std::mutex mutex;
+    /**
+     * Most recently used preambles go first.
+     */
+    std::list<CachedPreamble> preambles;
+};
+
+
+#endif // UNITTESTBOT_BITCODECOMPILER_H
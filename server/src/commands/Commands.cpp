@@ -6,6 +6,17 @@
 
 uint32_t Commands::threadsPerUser = 0;
 uint32_t Commands::kleeProcessNumber = 0;
+uint32_t Commands::kleePortfolioSize = 0;
+uint32_t Commands::kleeMemoryBudget = 0;
+uint32_t Commands::unityBuildSize = 0;
+uint32_t Commands::projectSessionCacheSize = 4;
+uint32_t Commands::projectSessionCacheMemory = 512;
+uint32_t Commands::maxJobs = 0;
+bool Commands::traceRequests = false;
+std::vector<std::string> Commands::kleeWorkers;
+bool Commands::kleeWorker = false;
+fs::path Commands::artifactStorePath;
+uint32_t Commands::artifactStoreSize = 4096;
 
 Commands::MainCommands::MainCommands(CLI::App &app) {
     app.set_help_all_flag("--help-all", "Expand all help");
@@ -52,6 +63,41 @@ Commands::ServerCommandOptions::ServerCommandOptions(CLI::App *command) {
         ->transform(CLI::CheckedTransformer(verbosityMap, CLI::ignore_case));
     command->add_option("--klee-process-number", kleeProcessNumber,
                         "Number of threads for KLEE in interactive mode");
+    command->add_option("--klee-portfolio-size", kleePortfolioSize,
+                        "Number of KLEE searcher configurations run in parallel for each function "
+                        "in non-interactive mode (0 or 1 disables portfolio mode)");
+    command->add_option("--klee-memory-budget", kleeMemoryBudget,
+                        "Total memory in megabytes available to all KLEE processes of the server "
+                        "(0 disables memory admission control)");
+    command->add_option("--unity-build-size", unityBuildSize,
+                        "Maximum number of generated C test files of one target compiled as a "
+                        "single translation unit (0 or 1 disables unity build)");
+    command->add_option("--project-session-cache-size", projectSessionCacheSize,
+                        "Number of projects whose parsed build databases are kept in memory "
+                        "between requests (0 disables the cache)");
+    command->add_option("--project-session-cache-memory", projectSessionCacheMemory,
+                        "Total size in megabytes of link and compile commands JSON files of "
+                        "projects kept in the session cache, least recently used projects are "
+                        "dropped above it");
+    command->add_option("--max-jobs", maxJobs,
+                        "Maximum number of KLEE, build and parallel generation jobs run at once "
+                        "by all clients of the server (0 means the number of CPU cores)");
+    command->add_flag("--trace", traceRequests,
+                      "Save spans of every request as a Chrome trace-event JSON file in the "
+                      "client log directory");
+    command->add_option("--klee-workers", kleeWorkers,
+                        "Addresses (host:port) of UTBot servers which run KLEE for functions of "
+                        "this server in non-interactive mode")
+        ->delimiter(',');
+    command->add_flag("--klee-worker", kleeWorker,
+                      "Run KLEE for other UTBot servers which list this one in --klee-workers");
+    command->add_option("--artifact-store", artifactStorePath,
+                        "Directory with linked bitcode files shared by this server and its KLEE "
+                        "workers, it has to be the same on all of them (default is in the logs "
+                        "directory)");
+    command->add_option("--artifact-store-size", artifactStoreSize,
+                        "Size limit in megabytes of the artifact store, least recently used files "
+                        "are removed above it (0 disables the limit)");
 }
 
 fs::path Commands::ServerCommandOptions::getLogPath() {
@@ -74,6 +120,42 @@ unsigned int Commands::ServerCommandOptions::getKleeProcessNumber() {
     return kleeProcessNumber;
 }
 
+unsigned int Commands::ServerCommandOptions::getKleePortfolioSize() {
+    return kleePortfolioSize;
+}
+
+unsigned int Commands::ServerCommandOptions::getKleeMemoryBudget() {
+    return kleeMemoryBudget;
+}
+
+unsigned int Commands::ServerCommandOptions::getUnityBuildSize() {
+    return unityBuildSize;
+}
+
+unsigned int Commands::ServerCommandOptions::getProjectSessionCacheSize() {
+    return projectSessionCacheSize;
+}
+
+unsigned int Commands::ServerCommandOptions::getProjectSessionCacheMemory() {
+    return projectSessionCacheMemory;
+}
+
+unsigned int Commands::ServerCommandOptions::getMaxJobs() {
+    return maxJobs;
+}
+
+std::vector<std::string> Commands::ServerCommandOptions::getKleeWorkers() {
+    return kleeWorkers;
+}
+
+fs::path Commands::ServerCommandOptions::getArtifactStorePath() {
+    return artifactStorePath;
+}
+
+unsigned int Commands::ServerCommandOptions::getArtifactStoreSize() {
+    return artifactStoreSize;
+}
+
 const std::map<std::string, loguru::NamedVerbosity> Commands::ServerCommandOptions::verbosityMap = {
     { "trace", loguru::NamedVerbosity::Verbosity_MAX },
     { "debug", loguru::NamedVerbosity::Verbosity_1 },
@@ -9,12 +9,24 @@
 
 #include <CLI11.hpp>
 #include <string>
+#include <vector>
 
 
 
 namespace Commands {
     extern uint32_t threadsPerUser;
     extern uint32_t kleeProcessNumber;
+    extern uint32_t kleePortfolioSize;
+    extern uint32_t kleeMemoryBudget;
+    extern uint32_t unityBuildSize;
+    extern uint32_t projectSessionCacheSize;
+    extern uint32_t projectSessionCacheMemory;
+    extern uint32_t maxJobs;
+    extern bool traceRequests;
+    extern std::vector<std::string> kleeWorkers;
+    extern bool kleeWorker;
+    extern fs::path artifactStorePath;
+    extern uint32_t artifactStoreSize;
 
     struct MainCommands {
         explicit MainCommands(CLI::App &app);
@@ -47,6 +59,24 @@ namespace Commands {
         unsigned int getThreadsPerUser();
 
         unsigned int getKleeProcessNumber();
+
+        unsigned int getKleePortfolioSize();
+
+        unsigned int getKleeMemoryBudget();
+
+        unsigned int getUnityBuildSize();
+
+        unsigned int getProjectSessionCacheSize();
+
+        unsigned int getProjectSessionCacheMemory();
+
+        unsigned int getMaxJobs();
+
+        std::vector<std::string> getKleeWorkers();
+
+        fs::path getArtifactStorePath();
+
+        unsigned int getArtifactStoreSize();
     private:
         unsigned int port = 0;
         fs::path logPath;
@@ -1,12 +1,91 @@
 #include "FetcherUtils.h"
+#include "RequestEnvironment.h"
 #include "environment/EnvironmentPaths.h"
 #include "exceptions/CompilationDatabaseException.h"
 #include "building/CompilationDatabase.h"
+#include "utils/ExecUtils.h"
 
 #include "loguru.h"
 
+#include <clang/Frontend/FrontendAction.h>
+#include <clang/Frontend/MultiplexConsumer.h>
+
 #include <memory>
 
+namespace {
+    /**
+     * Passes everything to the consumer of the wrapped action and stops parsing once the
+     * request is cancelled: parser stops as soon as HandleTopLevelDecl returns false, so a
+     * cancelled request doesn't parse the rest of a translation unit.
+     */
+    class CancellableASTConsumer : public clang::MultiplexConsumer {
+    public:
+        explicit CancellableASTConsumer(std::unique_ptr<clang::ASTConsumer> consumer)
+            : clang::MultiplexConsumer(makeConsumers(std::move(consumer))) {
+        }
+
+        bool HandleTopLevelDecl(clang::DeclGroupRef declGroup) override {
+            // checking the server context takes a lock, so it is not done on every declaration
+            if (++declarationsCount % CANCELLATION_CHECK_PERIOD == 0 &&
+                RequestEnvironment::isCancelled()) {
+                cancelled = true;
+            }
+            return !cancelled && clang::MultiplexConsumer::HandleTopLevelDecl(declGroup);
+        }
+
+        void HandleTranslationUnit(clang::ASTContext &context) override {
+            // matchers are not run for a cancelled request
+            if (!cancelled && !RequestEnvironment::isCancelled()) {
+                clang::MultiplexConsumer::HandleTranslationUnit(context);
+            }
+        }
+
+    private:
+        static constexpr size_t CANCELLATION_CHECK_PERIOD = 64;
+
+        size_t declarationsCount = 0;
+        bool cancelled = false;
+
+        static std::vector<std::unique_ptr<clang::ASTConsumer>>
+        makeConsumers(std::unique_ptr<clang::ASTConsumer> consumer) {
+            std::vector<std::unique_ptr<clang::ASTConsumer>> consumers;
+            consumers.push_back(std::move(consumer));
+            return consumers;
+        }
+    };
+
+    class CancellableFrontendAction : public clang::WrapperFrontendAction {
+    public:
+        explicit CancellableFrontendAction(std::unique_ptr<clang::FrontendAction> action)
+            : clang::WrapperFrontendAction(std::move(action)) {
+        }
+
+    protected:
+        std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance &compiler,
+                                                              llvm::StringRef inFile) override {
+            auto consumer = clang::WrapperFrontendAction::CreateASTConsumer(compiler, inFile);
+            if (consumer == nullptr) {
+                return nullptr;
+            }
+            return std::make_unique<CancellableASTConsumer>(std::move(consumer));
+        }
+    };
+
+    class CancellableFrontendActionFactory : public clang::tooling::FrontendActionFactory {
+    public:
+        explicit CancellableFrontendActionFactory(clang::tooling::FrontendActionFactory *factory)
+            : factory(factory) {
+        }
+
+        std::unique_ptr<clang::FrontendAction> create() override {
+            return std::make_unique<CancellableFrontendAction>(factory->create());
+        }
+
+    private:
+        clang::tooling::FrontendActionFactory *const factory;
+    };
+}
+
 types::Type ParamsHandler::getType(const clang::QualType &paramDef,
                                    const clang::QualType &paramDecl,
                                    const clang::SourceManager &sourceManager) {
@@ -51,6 +130,7 @@ void ClangToolRunner::run(const fs::path &file,
     if (!Paths::isSourceFile(file) && (!Paths::isHeaderFile(file) || onlySource)) {
         return;
     }
+    ExecUtils::throwIfCancelled();
     if (onlySource) {
         if (!CollectionUtils::contains(compilationDatabase->getAllFiles(), file)) {
             throw CompilationDatabaseException(
@@ -66,7 +146,15 @@ void ClangToolRunner::run(const fs::path &file,
         clangTool->mapVirtualFile(file.c_str(), virtualFileContent.value());
     }
     setResourceDirOption(clangTool.get());
-    int status = clangTool->run(toolAction);
+    int status;
+    if (auto factory = dynamic_cast<clang::tooling::FrontendActionFactory *>(toolAction)) {
+        CancellableFrontendActionFactory cancellableFactory(factory);
+        status = clangTool->run(&cancellableFactory);
+    } else {
+        status = clangTool->run(toolAction);
+    }
+    // AST of a cancelled request is incomplete, so nothing may be taken from it
+    ExecUtils::throwIfCancelled();
     if (!ignoreDiagnostics) {
         checkStatus(status);
     }
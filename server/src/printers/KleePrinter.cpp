@@ -84,6 +84,7 @@ fs::path KleePrinter::writeTmpKleeFile(
 
     resetStream();
     writeCopyrightHeader();
+    methodLineRanges.clear();
 
     bool onlyForOneEntity = onlyForOneFunction || onlyForOneClass;
     auto unitInfo = buildDatabase->getClientCompilationUnitInfo(tests.sourceFilePath);
@@ -122,6 +123,7 @@ fs::path KleePrinter::writeTmpKleeFile(
 
     writeAccessPrivateMacros(typesHandler, tests, false);
 
+    MethodOffsets methodOffsets;
     for (const auto &[methodName, testMethod] : tests.methods) {
         if (!methodFilter(testMethod)) {
             continue;
@@ -130,6 +132,7 @@ fs::path KleePrinter::writeTmpKleeFile(
             (onlyForOneClass && testMethod.isClassMethod() && testMethod.classObj->type.typeName() != testedClass)) {
             continue;
         }
+        size_t methodBegin = ss.tellp();
         try {
             if (srcLanguage == utbot::Language::C) {
                 writeTestedFunction(tests, testMethod, predicateInfo, testedMethod, onlyForOneEntity, true);
@@ -142,13 +145,42 @@ fs::path KleePrinter::writeTmpKleeFile(
                 "Could not generate klee code for method \'" + methodName + "\', skipping it. ";
             LOG_S(WARNING) << message << e.what();
         }
+        methodOffsets.push_back({ testMethod.name, { methodBegin, static_cast<size_t>(ss.tellp()) } });
     }
 
-    FileSystemUtils::writeToFile(kleeFilePath, ss.str());
+    std::string content = ss.str();
+    methodLineRanges = toLineRanges(content, methodOffsets);
+    FileSystemUtils::writeToFile(kleeFilePath, content);
     LOG_S(DEBUG) << "TmpKleeFile written to " << kleeFilePath;
     return kleeFilePath;
 }
 
+const KleePrinter::MethodLineRanges &KleePrinter::getMethodLineRanges() const {
+    return methodLineRanges;
+}
+
+KleePrinter::MethodLineRanges KleePrinter::toLineRanges(const std::string &content,
+                                                        const MethodOffsets &methodOffsets) {
+    MethodLineRanges lineRanges;
+    // methods are written one after another, so lines are counted in a single pass
+    size_t line = 1;
+    size_t offset = 0;
+    for (const auto &[methodName, offsets] : methodOffsets) {
+        const auto &[begin, end] = offsets;
+        line += std::count(content.begin() + offset, content.begin() + begin, '\n');
+        offset = begin;
+        if (end <= begin) {
+            continue;
+        }
+        // the code ends with NL, it belongs to the last line and doesn't start a new one
+        size_t lastLine = line + std::count(content.begin() + begin, content.begin() + end - 1, '\n');
+        lineRanges[methodName] = { line, lastLine };
+        line = lastLine;
+        offset = end - 1;
+    }
+    return lineRanges;
+}
+
 void KleePrinter::declTestEntryPoint(const Tests &tests,
                                      const Tests::MethodDescription &testMethod,
                                      bool isWrapped) {
@@ -44,9 +44,31 @@ namespace printer {
                                     const utbot::ProjectContext &projectContext);
 
     [[nodiscard]] std::vector<std::string> getIncludePaths(const Tests &tests, const PathSubstitution &substitution) const;
+
+        /**
+         * Lines (1-based, inclusive) occupied by the code of every method in the file written
+         * by the last call of writeTmpKleeFile. Used to attribute compilation errors to methods.
+         */
+        using MethodLineRanges = std::unordered_map<std::string, std::pair<size_t, size_t>>;
+
+        /**
+         * Character offsets [begin, end) of the code of every method in the written file, in
+         * the order the methods are written.
+         */
+        using MethodOffsets = std::vector<std::pair<std::string, std::pair<size_t, size_t>>>;
+
+        [[nodiscard]] const MethodLineRanges &getMethodLineRanges() const;
+
+        /**
+         * @brief Converts offsets of methods in content to lines. Methods which wrote nothing
+         * have no range.
+         */
+        static MethodLineRanges toLineRanges(const std::string &content,
+                                             const MethodOffsets &methodOffsets);
     private:
         types::TypesHandler const *typesHandler;
         std::shared_ptr<BuildDatabase> buildDatabase;
+        MethodLineRanges methodLineRanges;
 
         using PredInfo = LineInfo::PredicateInfo;
         struct ConstraintsState {
@@ -10,11 +10,20 @@
 #include "RelativeMakefilePrinter.h"
 #include "utils/ArgumentsUtils.h"
 #include "utils/CompilationUtils.h"
+#include "utils/Copyright.h"
 #include "utils/DynamicLibraryUtils.h"
+#include "utils/FileSystemUtils.h"
+#include "utils/HashUtils.h"
 #include "utils/LinkerUtils.h"
+#include "utils/PrinterUtils.h"
 #include "utils/SanitizerUtils.h"
 #include "utils/StringUtils.h"
 
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
 namespace printer {
     using namespace DynamicLibraryUtils;
     using StringUtils::stringFormat;
@@ -30,6 +39,51 @@ namespace printer {
     static const std::string SHARED_FLAG = "-shared";
     static const std::string RELOCATE_FLAG = "-r";
     static const std::string OPTIMIZATION_FLAG = "-O0";
+    static const std::string GTEST_PCH_HEADER = "gtest_pch.h";
+    // a few megabytes per combination of compiler and flags
+    static const uintmax_t GTEST_CACHE_CAPACITY = 256ull << 20;
+    // instrumented objects of a project, a few builds of a large one
+    static const uintmax_t INSTRUMENTED_OBJECT_CACHE_CAPACITY = 1ull << 30;
+    static const std::string UNITY_TEST_FILE_VARIABLE = "UTBOT_UNITY_TEST_FILE";
+    // runs tests of a single test file, so the executable behaves as the one built from that file
+    static const std::string UNITY_MAIN = R"(#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "gtest/gtest.h"
+
+int main(int argc, char **argv) {
+    printf("Running main() from %s\n", __FILE__);
+    ::testing::InitGoogleTest(&argc, argv);
+    const char *testFile = std::getenv("UTBOT_UNITY_TEST_FILE");
+    if (testFile != nullptr) {
+        std::string suffix = std::string("/") + testFile;
+        std::string excluded;
+        const ::testing::UnitTest *unitTest = ::testing::UnitTest::GetInstance();
+        for (int i = 0; i < unitTest->total_test_suite_count(); i++) {
+            const ::testing::TestSuite *testSuite = unitTest->GetTestSuite(i);
+            for (int j = 0; j < testSuite->total_test_count(); j++) {
+                const ::testing::TestInfo *testInfo = testSuite->GetTestInfo(j);
+                std::string file = testInfo->file();
+                bool isOwnTest = file == testFile ||
+                                 (file.size() >= suffix.size() &&
+                                  file.compare(file.size() - suffix.size(), suffix.size(), suffix) == 0);
+                if (!isOwnTest) {
+                    excluded += std::string(":") + testSuite->name() + "." + testInfo->name();
+                }
+            }
+        }
+        if (!excluded.empty()) {
+            std::string &filter = ::testing::GTEST_FLAG(filter);
+            filter += filter.find('-') == std::string::npos ? "-" + excluded.substr(1) : excluded;
+        }
+    }
+    return RUN_ALL_TESTS();
+}
+)";
+    // includes every generated test file starts with: gtest and the ones from the test header
+    static const std::string GTEST_PCH_CONTENT =
+        "#include <cstring>\\n#include <unistd.h>\\n#include \"gtest/gtest.h\"\\n";
     static const std::unordered_set<std::string> UNSUPPORTED_FLAGS_AND_OPTIONS_TEST_MAKE = {
         // See https://gcc.gnu.org/onlinedocs/gcc/Option-Summary.html
         "-ansi",
@@ -143,6 +197,18 @@ namespace printer {
         init();
     }
 
+    // changes once the file is replaced, e.g. by an update of the compiler or gtest
+    static std::string getFileStamp(const fs::path &path) {
+        std::error_code errorCode;
+        auto modificationTime = fs::last_write_time(path, errorCode);
+        auto size = fs::file_size(path, errorCode);
+        if (errorCode) {
+            return "";
+        }
+        return std::to_string(modificationTime.time_since_epoch().count()) + ":" +
+               std::to_string(size);
+    }
+
     void NativeMakefilePrinter::init() {
         bits32Flag = "";
         for (auto &[fileName, _] : testGen->tests) {
@@ -156,11 +222,16 @@ namespace printer {
         declareAction(stringFormat("$(shell mkdir -p %s >/dev/null)", getRelativePath(buildDirectory)));
         declareAction(stringFormat("$(shell mkdir -p %s >/dev/null)",
                                    getRelativePath(dependencyDirectory)));
+        const fs::path instrumentedObjectCacheDir =
+            Paths::getInstrumentedObjectCacheDir(testGen->projectContext);
+        FileSystemUtils::evictLeastRecentlyUsed(instrumentedObjectCacheDir,
+                                                INSTRUMENTED_OBJECT_CACHE_CAPACITY);
+        declareAction(stringFormat("$(shell mkdir -p %s >/dev/null)",
+                                   getRelativePath(instrumentedObjectCacheDir)));
         declareTarget(FORCE, {}, {});
 
         comment("{ gtest");
 
-        fs::path gtestBuildDirectory = getRelativePath(buildDirectory / "googletest");
         fs::path defaultPath = "default.c";
         std::vector<std::string> defaultGtestCompileCommandLine{
             getRelativePathForLinker(primaryCxxCompiler),
@@ -169,6 +240,24 @@ namespace printer {
             "-std=c++11",
             FPIC_FLAG,
             defaultPath };
+        // gtest objects depend only on the compiler, its standard library, gtest sources and
+        // flags, so they are shared by projects
+        const fs::path gtestLib = Paths::getGtestLibPath();
+        std::vector<std::string> gtestKey = {
+            primaryCxxCompiler.string(),
+            getFileStamp(primaryCxxCompiler),
+            gtestLib.string(),
+            getFileStamp(gtestLib / "googletest" / "src" / "gtest-all.cc"),
+            getFileStamp(gtestLib / "googletest" / "include" / "gtest" / "gtest.h"),
+            coverageLinkFlags,
+            sanitizerLinkFlags
+        };
+        CollectionUtils::extend(gtestKey, defaultGtestCompileCommandLine);
+        // objects of other compilers and gtest versions are never used again
+        FileSystemUtils::evictLeastRecentlyUsed(Paths::getGtestCacheDir(), GTEST_CACHE_CAPACITY);
+        fs::path gtestBuildDirectory =
+            getRelativePath(Paths::getGtestCacheDir() / HashUtils::stableHash(gtestKey));
+        declareAction(stringFormat("$(shell mkdir -p %s >/dev/null)", gtestBuildDirectory));
         utbot::CompileCommand defaultGtestCompileCommand{ defaultGtestCompileCommandLine,
                                                           getRelativePath(buildDirectory), defaultPath };
         gtestAllTargets(defaultGtestCompileCommand, gtestBuildDirectory);
@@ -201,14 +290,11 @@ namespace printer {
             { CompilationUtils::getIncludePath(getRelativePath(gtestLib) / "googletest" / "include"),
               CompilationUtils::getIncludePath(getRelativePath(gtestLib) / "googletest") });
 
-        declareTarget(gtestAllObjectFile, { gtestCompilationArguments.getSourcePath() },
-                      { gtestCompilationArguments.toStringWithChangingDirectory() });
+        declareSharedGtestTarget(gtestCompilationArguments);
         declareShellVariable("GTEST_ALL", gtestAllObjectFile,
                              [&](const std::string& arg1, const std::string& arg2) {
             declareVariable(arg1, arg2);
         });
-
-        artifacts.push_back(gtestAllObjectFile);
     }
 
     void NativeMakefilePrinter::gtestMainTargets(const utbot::CompileCommand &defaultCompileCommand,
@@ -223,14 +309,64 @@ namespace printer {
                  CompilationUtils::getIncludePath(getRelativePath(gtestLib / "googletest"))});
         gtestCompilationArguments.setSourcePath(getRelativePath(gtestMainSourceFile));
         gtestCompilationArguments.setOutput(gtestMainObjectFile);
-        declareTarget(gtestMainObjectFile, { gtestCompilationArguments.getSourcePath() },
-                      { gtestCompilationArguments.toStringWithChangingDirectory() });
+        declareSharedGtestTarget(gtestCompilationArguments);
         declareShellVariable("GTEST_MAIN", gtestMainObjectFile,
                              [&](const std::string& arg1, const std::string& arg2) {
             declareVariable(arg1, arg2);
         });
+    }
 
-        artifacts.push_back(gtestMainObjectFile);
+    void NativeMakefilePrinter::declareSharedGtestTarget(utbot::CompileCommand gtestCompilationArguments) {
+        // several projects may build the same object concurrently, so it is published atomically
+        fs::path objectFile = gtestCompilationArguments.getOutput();
+        std::string temporaryObjectFile = objectFile.string() + ".$$$$";
+        gtestCompilationArguments.setOutput(temporaryObjectFile);
+        declareTarget(objectFile, { gtestCompilationArguments.getSourcePath() },
+                      { stringFormat("%s && mv -f %s %s",
+                                     gtestCompilationArguments.toStringWithChangingDirectory(),
+                                     temporaryObjectFile, objectFile) });
+    }
+
+    std::size_t NativeMakefilePrinter::getFlagsHash(const utbot::CompileCommand &compileCommand) {
+        std::size_t flagsHash = 0;
+        HashUtils::hashCombine(flagsHash, compileCommand.getDirectory());
+        for (const std::string &argument : compileCommand.getCommandLine()) {
+            if (argument != compileCommand.getSourcePath().string() &&
+                argument != compileCommand.getOutput().string()) {
+                HashUtils::hashCombine(flagsHash, argument);
+            }
+        }
+        return flagsHash;
+    }
+
+    fs::path NativeMakefilePrinter::addGtestPchTarget(
+        const utbot::CompileCommand &testCompilationCommand) {
+        // test files compiled with the same flags share one precompiled header
+        fs::path pchDirectory = getRelativePath(buildDirectory / "googletest" / "pch" /
+                                                std::to_string(getFlagsHash(testCompilationCommand)));
+        fs::path pchHeader = pchDirectory / GTEST_PCH_HEADER;
+        fs::path pchFile = Paths::addExtension(pchHeader, ".gch");
+
+        // makefiles of several test files may build the header concurrently, so both files
+        // are published atomically
+        declareTarget(pchHeader, {},
+                      { stringFormat("mkdir -p %s", pchDirectory),
+                        stringFormat("printf '%s' > $@.$$$$ && mv -f $@.$$$$ $@",
+                                     GTEST_PCH_CONTENT) });
+
+        auto pchCompilationCommand = testCompilationCommand;
+        std::string temporaryPchFile = pchFile.string() + ".$$$$";
+        pchCompilationCommand.setSourcePath(pchHeader);
+        pchCompilationCommand.setOutput(temporaryPchFile);
+        pchCompilationCommand.addFlagsToBegin({ "-x", "c++-header" });
+        declareTarget(pchFile, { pchHeader },
+                      { stringFormat("%s && mv -f %s %s",
+                                     pchCompilationCommand.toStringWithChangingDirectoryToNew(
+                                         getRelativePath(pchCompilationCommand.getDirectory())),
+                                     temporaryPchFile, pchFile) });
+
+        artifacts.push_back(pchDirectory);
+        return pchHeader;
     }
 
     void NativeMakefilePrinter::addCompileTarget(
@@ -273,13 +409,98 @@ namespace printer {
 
         declareTarget(compileCommand.getOutput(), { compileCommand.getSourcePath(), dependencyFile },
                       { makingDependencyDirectory,
-                        compileCommand.toStringWithChangingDirectoryToNew(
-                                getRelativePath(compileCommand.getDirectory())),
+                        getCachedCompilationAction(compileCommand, temporaryDependencyFile),
                         postCompileAction });
 
         artifacts.push_back(compileCommand.getOutput());
     }
 
+    std::string NativeMakefilePrinter::getCachedCompilationAction(
+        const utbot::CompileCommand &compileCommand,
+        const fs::path &temporaryDependencyFile) const {
+        fs::path compilationDirectory = getRelativePath(compileCommand.getDirectory());
+        fs::path objectFile = compileCommand.getOutput();
+        // gcc writes coverage notes next to the object, they have to be cached along with it
+        fs::path coverageNotesFile = Paths::replaceExtension(objectFile, ".gcno");
+        bool writesCoverageNotes =
+            CollectionUtils::contains(compileCommand.getCommandLine(), "--coverage");
+        fs::path preprocessedFile = Paths::addExtension(objectFile, ".i");
+
+        // preprocessing also writes the dependency file, so it is up to date on cache hit
+        auto preprocessCommand = compileCommand;
+        preprocessCommand.addFlagToBegin("-E");
+        preprocessCommand.setOutput(preprocessedFile);
+
+        // the same source may be compiled to different objects, e.g. by makefiles of several
+        // test files, so the output is not a part of the key; the compilers' stamps cover
+        // system headers, which are not listed in the dependency file
+        std::vector<std::string> commandKey = { compileCommand.getDirectory().string(),
+                                                getFileStamp(primaryCompiler),
+                                                getFileStamp(primaryCxxCompiler) };
+        for (const std::string &argument : compileCommand.getCommandLine()) {
+            if (argument != objectFile.string()) {
+                commandKey.push_back(argument);
+            }
+        }
+        std::string commandHash = HashUtils::stableHash(commandKey);
+        fs::path cacheDirectory =
+            getRelativePath(Paths::getInstrumentedObjectCacheDir(testGen->projectContext));
+        // the manifest holds the key of the last preprocessed source and checksums of the files
+        // it was made of, so an unchanged source is restored without preprocessing
+        std::string manifestFile = stringFormat("%s/%s.manifest", cacheDirectory, commandHash);
+        std::string cachedFilePrefix = stringFormat("%s/%s_$$key", cacheDirectory, commandHash);
+        std::string cachedObjectFile = cachedFilePrefix + ".o";
+        std::string cachedCoverageNotesFile = cachedFilePrefix + ".gcno";
+        std::string cachedDependencyFile = cachedFilePrefix + ".d";
+
+        // files may be evicted one by one, an object without its notes is not a hit
+        std::string isCached = writesCoverageNotes
+                                   ? stringFormat("[ -f %s ] && [ -f %s ]", cachedObjectFile,
+                                                  cachedCoverageNotesFile)
+                                   : stringFormat("[ -f %s ]", cachedObjectFile);
+        std::string directLookup = stringFormat(
+            "m=$$(cat %s 2>/dev/null) && key=$$(printf '%%s\\n' \"$$m\" | head -n 1) && "
+            "[ -n \"$$key\" ] && %s && [ -f %s ] && "
+            "printf '%%s\\n' \"$$m\" | tail -n +2 | (cd %s && sha1sum -c --status -)",
+            manifestFile, isCached, cachedDependencyFile, compilationDirectory);
+        // line markers of the preprocessed source name every file it was made of
+        std::string storeManifest = stringFormat(
+            "{ { printf '%%s\\n' $$key && sed -n 's/^# [0-9]* \"\\([^<].*\\)\".*/\\1/p' %s | "
+            "sort -u | (cd %s && xargs -d '\\n' -r sha1sum); } > %s.$$$$ && "
+            "cp -f %s %s.$$$$ && mv -f %s.$$$$ %s && mv -f %s.$$$$ %s || rm -f %s.$$$$ %s.$$$$; }",
+            preprocessedFile, compilationDirectory, manifestFile, temporaryDependencyFile,
+            cachedDependencyFile, cachedDependencyFile, cachedDependencyFile, manifestFile,
+            manifestFile, manifestFile, cachedDependencyFile);
+        std::string computeKey = stringFormat(
+            "(%s) && key=$$(sha1sum < %s | cut -d' ' -f1) && %s && rm -f %s",
+            preprocessCommand.toStringWithChangingDirectoryToNew(compilationDirectory),
+            preprocessedFile, storeManifest, preprocessedFile);
+        // restored files are touched, so the cache evicts the least recently used ones
+        std::string restore = stringFormat(
+            "cp -f %s %s && { [ ! -f %s ] || cp -f %s %s; } && touch -c %s %s %s %s",
+            cachedObjectFile, objectFile, cachedCoverageNotesFile, cachedCoverageNotesFile,
+            coverageNotesFile, cachedObjectFile, cachedCoverageNotesFile, cachedDependencyFile,
+            manifestFile);
+        // the dependency file names the target of the makefile which stored it
+        std::string restoreDependencies = stringFormat("sed '1s|^[^:]*:|$@:|' %s > %s",
+                                                       cachedDependencyFile,
+                                                       temporaryDependencyFile);
+        // several makefiles may compile the same object concurrently, so it is published
+        // atomically and after the coverage notes
+        std::string store = stringFormat(
+            "{ [ ! -f %s ] || { cp -f %s %s.$$$$ && mv -f %s.$$$$ %s; }; } && "
+            "cp -f %s %s.$$$$ && mv -f %s.$$$$ %s",
+            coverageNotesFile, coverageNotesFile, cachedCoverageNotesFile, cachedCoverageNotesFile,
+            cachedCoverageNotesFile, objectFile, cachedObjectFile, cachedObjectFile,
+            cachedObjectFile);
+        std::string compile = stringFormat(
+            "rm -f %s && (%s) && %s", coverageNotesFile,
+            compileCommand.toStringWithChangingDirectoryToNew(compilationDirectory), store);
+        return stringFormat("if %s; then %s && %s; else %s && if %s; then %s; else %s; fi; fi",
+                            directLookup, restore, restoreDependencies, computeKey, isCached,
+                            restore, compile);
+    }
+
     BuildResult NativeMakefilePrinter::addObjectFile(const fs::path &objectFile,
                                                      const std::string &suffixForParentOfStubs) {
 
@@ -311,7 +532,7 @@ namespace printer {
         return buildResult;
     }
 
-    void NativeMakefilePrinter::addTestTarget(const fs::path &sourcePath) {
+    utbot::CompileCommand NativeMakefilePrinter::getTestCompilationCommand(const fs::path &sourcePath) const {
         auto compilationUnitInfo = testGen->getClientCompilationUnitInfo(sourcePath);
         auto testCompilationCommand = compilationUnitInfo->command;
         testCompilationCommand.setBuildTool(getRelativePathForLinker(primaryCxxCompiler));
@@ -328,7 +549,6 @@ namespace printer {
         testCompilationCommand.addFlagsToBegin(SANITIZER_NEEDED_FLAGS);
 
         fs::path testSourcePath = Paths::sourcePathToTestPath(testGen->projectContext, sourcePath);
-        fs::path compilationDirectory = compilationUnitInfo->getDirectory();
         fs::path testObjectDir = Paths::getTestObjectDir(testGen->projectContext);
         fs::path testSourceRelativePath = fs::relative(testSourcePath, testGen->projectContext.testDirPath);
         fs::path testObjectPathRelative = getRelativePath(
@@ -337,34 +557,117 @@ namespace printer {
                 testObjectPathRelative);
         testCompilationCommand.setSourcePath(
                 getRelativePath(testSourcePath));
+        return testCompilationCommand;
+    }
+
+    fs::path NativeMakefilePrinter::getUnitySourcePath() const {
+        std::size_t groupHash = 0;
+        for (const fs::path &groupSourcePath : unityGroup) {
+            HashUtils::hashCombine(groupHash, groupSourcePath);
+        }
+        return Paths::getTestObjectDir(testGen->projectContext) / "unity" /
+               (std::to_string(groupHash) + "_unity_test.cpp");
+    }
+
+    std::string NativeMakefilePrinter::getUnityIncludePath(const fs::path &sourcePath) const {
+        fs::path testSourcePath = Paths::sourcePathToTestPath(testGen->projectContext, sourcePath);
+        return fs::relative(testSourcePath, getUnitySourcePath().parent_path()).string();
+    }
+
+    fs::path NativeMakefilePrinter::writeUnitySource() const {
+        fs::path unitySourcePath = getUnitySourcePath();
+        std::stringstream unitySource;
+        unitySource << Copyright::GENERATED_C_CPP_FILE_HEADER << "\n";
+        for (size_t i = 0; i < unityGroup.size(); i++) {
+            // every test file gets its own namespace, so declarations of different test headers
+            // don't clash
+            unitySource << stringFormat("#define %s %s_%zu\n", PrinterUtils::TEST_NAMESPACE,
+                                        PrinterUtils::TEST_NAMESPACE, i)
+                        << stringFormat("#include \"%s\"\n", getUnityIncludePath(unityGroup[i]))
+                        << stringFormat("#undef %s\n\n", PrinterUtils::TEST_NAMESPACE);
+        }
+        unitySource << UNITY_MAIN;
+
+        // every makefile of the group writes the same source, rewriting it would trigger rebuild
+        std::ifstream existingSource(unitySourcePath);
+        std::stringstream existingContent;
+        existingContent << existingSource.rdbuf();
+        if (!existingSource.is_open() || existingContent.str() != unitySource.str()) {
+            // makefiles of the group may be printed concurrently, so the source is published
+            // atomically
+            static std::atomic<uint64_t> nextTmpId = 0;
+            fs::path temporarySourcePath =
+                unitySourcePath.string() + "." + std::to_string(getpid()) + "_" +
+                std::to_string(nextTmpId++);
+            FileSystemUtils::writeToFile(temporarySourcePath, unitySource.str());
+            fs::rename(temporarySourcePath, unitySourcePath);
+        }
+        return unitySourcePath;
+    }
 
+    void NativeMakefilePrinter::addTestTarget(const fs::path &sourcePath) {
+        auto testCompilationCommand = getTestCompilationCommand(sourcePath);
+        std::vector<std::string> testDependencies{ testCompilationCommand.getSourcePath().string() };
+        std::vector<std::string> filesToLink{ "$(GTEST_MAIN)", "$(GTEST_ALL)" };
+        if (isUnityBuild()) {
+            fs::path unitySourcePath = writeUnitySource();
+            testCompilationCommand.setSourcePath(getRelativePath(unitySourcePath));
+            testCompilationCommand.setOutput(
+                getRelativePath(Paths::replaceExtension(unitySourcePath, ".o")));
+            testDependencies = { testCompilationCommand.getSourcePath().string() };
+            for (const fs::path &groupSourcePath : unityGroup) {
+                testDependencies.push_back(getRelativePath(Paths::sourcePathToTestPath(
+                    testGen->projectContext, groupSourcePath)).string());
+            }
+            // unity source has its own main
+            filesToLink = { "$(GTEST_ALL)" };
+        }
 
-        declareTarget(testCompilationCommand.getOutput(), {testCompilationCommand.getSourcePath().string() },
-                      { testCompilationCommand.toStringWithChangingDirectoryToNew(
-                              getRelativePath(testCompilationCommand.getDirectory())) });
+        // compiler picks up the precompiled gtest_pch.h.gch instead of parsing the header
+        fs::path gtestPchHeader = addGtestPchTarget(testCompilationCommand);
+        testCompilationCommand.addFlagsToBegin({ "-include", gtestPchHeader.string() });
+        testDependencies.push_back(Paths::addExtension(gtestPchHeader, ".gch").string());
+
+        // unity object and executable are built by makefiles of every test file of the group,
+        // possibly concurrently, so they are published atomically
+        auto getBuildOutput = [this](const fs::path &output) {
+            return isUnityBuild() ? fs::path(output.string() + ".$$$$") : output;
+        };
+        auto publish = [this](const std::string &command, const fs::path &output) {
+            return isUnityBuild() ? stringFormat("%s && mv -f %s.$$$$ %s", command, output, output)
+                                  : command;
+        };
+
+        fs::path testObjectFile = testCompilationCommand.getOutput();
+        testCompilationCommand.setOutput(getBuildOutput(testObjectFile));
+        declareTarget(testObjectFile, testDependencies,
+                      { publish(testCompilationCommand.toStringWithChangingDirectoryToNew(
+                                    getRelativePath(testCompilationCommand.getDirectory())),
+                                testObjectFile) });
+        testCompilationCommand.setOutput(testObjectFile);
 
         artifacts.push_back(testCompilationCommand.getOutput());
 
         auto rootLinkUnitInfo = testGen->getTargetBuildDatabase()->getClientLinkUnitInfo(rootPath);
         fs::path testExecutablePath = getTestExecutablePath(sourcePath);
 
-        std::vector<std::string> filesToLink{ "$(GTEST_MAIN)", "$(GTEST_ALL)", testCompilationCommand.getOutput(),
-                                             getRelativePath(
-                                                     sharedOutput.value()) };
+        filesToLink.push_back(testCompilationCommand.getOutput());
+        filesToLink.push_back(getRelativePath(sharedOutput.value()));
         if (rootLinkUnitInfo->commands.front().isArchiveCommand()) {
             std::vector<std::string> dynamicLinkCommandLine{ getRelativePathForLinker(cxxLinker), "$(LDFLAGS)",
                                                             bits32Flag,
                                                             pthreadFlag, coverageLinkFlags,
                                                             sanitizerLinkFlags, "-o",
-                                                            getRelativePath(
-                                                                    testExecutablePath) };
+                                                            getBuildOutput(getRelativePath(
+                                                                    testExecutablePath)) };
             CollectionUtils::extend(dynamicLinkCommandLine, filesToLink);
             dynamicLinkCommandLine.push_back(
                     getLibraryDirectoryFlag(getRelativePath(
                             sharedOutput.value().parent_path())));
             utbot::LinkCommand dynamicLinkCommand{dynamicLinkCommandLine, getRelativePath(buildDirectory) };
             declareTarget(getRelativePath(testExecutablePath), filesToLink,
-                          { dynamicLinkCommand.toStringWithChangingDirectory() });
+                          { publish(dynamicLinkCommand.toStringWithChangingDirectory(),
+                                    getRelativePath(testExecutablePath)) });
         } else {
             utbot::LinkCommand dynamicLinkCommand = rootLinkUnitInfo->commands.front();
             dynamicLinkCommand.setBuildTool(cxxLinker);
@@ -402,22 +705,31 @@ namespace printer {
 
             dynamicLinkCommand.setBuildTool(getRelativePathForLinker(cxxLinker));
             dynamicLinkCommand.setOutput(
-                    getRelativePath(testExecutablePath));
+                    getBuildOutput(getRelativePath(testExecutablePath)));
 
-            declareTarget(dynamicLinkCommand.getOutput(), filesToLink,
-                          {dynamicLinkCommand.toStringWithChangingDirectoryToNew(
-                                  getRelativePath(dynamicLinkCommand.getDirectory())) });
+            declareTarget(getRelativePath(testExecutablePath), filesToLink,
+                          { publish(dynamicLinkCommand.toStringWithChangingDirectoryToNew(
+                                        getRelativePath(dynamicLinkCommand.getDirectory())),
+                                    getRelativePath(testExecutablePath)) });
         }
 
         artifacts.push_back(getRelativePath(testExecutablePath));
     }
     fs::path NativeMakefilePrinter::getTestExecutablePath(const fs::path &sourcePath) const {
+        if (isUnityBuild()) {
+            return Paths::removeExtension(getUnitySourcePath());
+        }
         return Paths::removeExtension(
             Paths::removeExtension(Paths::getRecompiledFile(testGen->projectContext, sourcePath)));
     }
 
+    bool NativeMakefilePrinter::isUnityBuild() const {
+        return unityGroup.size() > 1;
+    }
+
     NativeMakefilePrinter::NativeMakefilePrinter(const NativeMakefilePrinter &baseMakefilePrinter,
-                                                 const fs::path &sourcePath)
+                                                 const fs::path &sourcePath,
+                                                 std::vector<fs::path> unityGroup)
         : RelativeMakefilePrinter(baseMakefilePrinter.pathToShellVariable),
           testGen(baseMakefilePrinter.testGen),
           rootPath(baseMakefilePrinter.rootPath),
@@ -432,7 +744,8 @@ namespace printer {
           dependencyDirectory(baseMakefilePrinter.dependencyDirectory),
           artifacts(baseMakefilePrinter.artifacts),
           buildResults(baseMakefilePrinter.buildResults),
-          sharedOutput(baseMakefilePrinter.sharedOutput) {
+          sharedOutput(baseMakefilePrinter.sharedOutput),
+          unityGroup(std::move(unityGroup)) {
         resetStream();
         ss << baseMakefilePrinter.ss.str();
 
@@ -461,6 +774,10 @@ namespace printer {
                                               SanitizerUtils::UBSAN_OPTIONS_VALUE);
         testRunCommand.addEnvironmentVariable(SanitizerUtils::ASAN_OPTIONS_NAME,
                                               SanitizerUtils::ASAN_OPTIONS_VALUE);
+        if (isUnityBuild()) {
+            testRunCommand.addEnvironmentVariable(UNITY_TEST_FILE_VARIABLE,
+                                                  getUnityIncludePath(sourcePath));
+        }
 
         declareTarget(TARGET_BUILD, { getRelativePath(testExecutablePath) }, {});
         declareTarget(TARGET_RUN, { TARGET_BUILD },
@@ -38,6 +38,12 @@ namespace printer {
 
         std::optional<fs::path> sharedOutput;
 
+        /**
+         * Sources whose test files are compiled together with the test file of this printer's
+         * source into a single translation unit and executable. Empty if unity build is off.
+         */
+        std::vector<fs::path> unityGroup{};
+
         fs::path getTemporaryDependencyFile(fs::path const &file);
 
         fs::path getDependencyFile(fs::path const &file);
@@ -48,10 +54,47 @@ namespace printer {
         void gtestMainTargets(const utbot::CompileCommand &defaultCompileCommand,
                               const fs::path &gtestBuildDir);
 
+        /**
+         * @brief Declares target for gtest object in the server-wide cache, see Paths::getGtestCacheDir.
+         */
+        void declareSharedGtestTarget(utbot::CompileCommand gtestCompilationArguments);
+
         fs::path getSharedLibrary(const fs::path &filePath);
 
+        /**
+         * @brief Compiles the object or takes it from Paths::getInstrumentedObjectCacheDir.
+         *
+         * The object is looked up by checksums of the files the source was made of last time,
+         * and only if they changed, by the preprocessed source.
+         * @return single recipe line, since the cache key is kept in a shell variable.
+         */
+        [[nodiscard]] std::string
+        getCachedCompilationAction(const utbot::CompileCommand &compileCommand,
+                                   const fs::path &temporaryDependencyFile) const;
+
+        [[nodiscard]] utbot::CompileCommand getTestCompilationCommand(const fs::path &sourcePath) const;
+
+        static std::size_t getFlagsHash(const utbot::CompileCommand &compileCommand);
+
         void addTestTarget(const fs::path &sourcePath);
 
+        [[nodiscard]] bool isUnityBuild() const;
+
+        [[nodiscard]] fs::path getUnitySourcePath() const;
+
+        /**
+         * @return path of the test file relative to the unity source, as it is included there.
+         */
+        [[nodiscard]] std::string getUnityIncludePath(const fs::path &sourcePath) const;
+
+        fs::path writeUnitySource() const;
+
+        /**
+         * @brief Declares targets for precompiled gtest header for the test compilation flags.
+         * @return path to the header which has to be included by the test file.
+         */
+        fs::path addGtestPchTarget(const utbot::CompileCommand &testCompilationCommand);
+
         BuildResult addObjectFile(const fs::path &objectFile,
                                   const std::string &suffixForParentOfStubs);
 
@@ -74,7 +117,8 @@ namespace printer {
                               std::map<std::string, fs::path, std::function<bool(const std::string&, const std::string&)>> pathToShellVariable);
 
         NativeMakefilePrinter(const NativeMakefilePrinter &baseMakefilePrinter,
-                              const fs::path &sourcePath);
+                              const fs::path &sourcePath,
+                              std::vector<fs::path> unityGroup = {});
 
         void init();
 
@@ -111,6 +111,8 @@ void RelativeMakefilePrinter::initializePathsToShellVariables() {
     declareShellVariable("LD", Paths::getLd(), declareVariableIfNotDefinedFunc);
 
     declareShellVariable("GTEST", Paths::getGtestLibPath(), declareVariableWithPriorityFunc);
+
+    declareShellVariable("GTEST_CACHE", Paths::getGtestCacheDir(), declareVariableWithPriorityFunc);
 }
 
 void RelativeMakefilePrinter::declareVariable(std::string const &name, std::string const &value) {
@@ -1,6 +1,9 @@
 #include "TestMakefilesPrinter.h"
+#include "commands/Commands.h"
 #include "utils/FileSystemUtils.h"
 
+#include <algorithm>
+#include <unordered_set>
 #include <utility>
 #include <utils/MakefileUtils.h>
 #include "utils/StringUtils.h"
@@ -69,6 +72,52 @@ namespace printer {
         objMakefilePrinter.addStubs(stubsSet);
     }
 
+    void TestMakefilesPrinter::addUnityGroups(const std::vector<fs::path> &sourcePaths) {
+        const size_t maxGroupSize = Commands::unityBuildSize;
+        if (maxGroupSize < 2) {
+            return;
+        }
+        struct Group {
+            std::vector<fs::path> sources;
+            std::unordered_set<std::string> methodNames;
+        };
+        std::unordered_map<std::size_t, std::vector<Group>> groupsByFlags;
+        for (const auto &sourcePath : sourcePaths) {
+            // C++ test headers include the whole source file, so they can't share a unit
+            if (!Paths::isCFile(sourcePath)) {
+                continue;
+            }
+            const auto &methods = sharedMakefilePrinter.testGen->tests.at(sourcePath).methods;
+            std::size_t flagsHash = NativeMakefilePrinter::getFlagsHash(
+                    sharedMakefilePrinter.getTestCompilationCommand(sourcePath));
+            auto &groups = groupsByFlags[flagsHash];
+            auto fits = [&](const Group &group) {
+                return group.sources.size() < maxGroupSize &&
+                       std::none_of(methods.begin(), methods.end(), [&](const auto &method) {
+                           return CollectionUtils::contains(group.methodNames, method.first);
+                       });
+            };
+            auto it = std::find_if(groups.begin(), groups.end(), fits);
+            if (it == groups.end()) {
+                it = groups.emplace(groups.end());
+            }
+            it->sources.push_back(sourcePath);
+            for (const auto &[methodName, _] : methods) {
+                it->methodNames.insert(methodName);
+            }
+        }
+        for (const auto &[_, groups] : groupsByFlags) {
+            for (const auto &group : groups) {
+                if (group.sources.size() < 2) {
+                    continue;
+                }
+                for (const auto &sourcePath : group.sources) {
+                    unityGroups[sourcePath] = group.sources;
+                }
+            }
+        }
+    }
+
     TestMakefilesContent TestMakefilesPrinter::GetMakefiles(const fs::path &sourcePath) {
         printer::DefaultMakefilePrinter generalMakefilePrinter;
         fs::path generalMakefilePath = Paths::getMakefilePathFromSourceFilePath(projectContext, sourcePath);
@@ -80,6 +129,11 @@ namespace printer {
 
         generalMakefilePrinter.declareTarget(FORCE, {}, {});
 
+        std::vector<fs::path> unityGroup;
+        if (auto it = unityGroups.find(sourcePath); it != unityGroups.end()) {
+            unityGroup = it->second;
+        }
+
         const std::string sharedMakefilePathRelative =
                 sharedMakefilePrinter.getRelativePath(sharedMakefilePath);
         const std::string objMakefilePathRelative =
@@ -117,7 +171,7 @@ namespace printer {
 
         return {generalMakefilePath,
                 generalMakefilePrinter.ss.str(),
-                NativeMakefilePrinter(sharedMakefilePrinter, sourcePath).ss.str(),
-                NativeMakefilePrinter(objMakefilePrinter, sourcePath).ss.str()};
+                NativeMakefilePrinter(sharedMakefilePrinter, sourcePath, unityGroup).ss.str(),
+                NativeMakefilePrinter(objMakefilePrinter, sourcePath, unityGroup).ss.str()};
     }
 }
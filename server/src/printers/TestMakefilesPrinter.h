@@ -24,6 +24,7 @@ namespace printer {
         utbot::ProjectContext projectContext;
         printer::NativeMakefilePrinter sharedMakefilePrinter;
         printer::NativeMakefilePrinter objMakefilePrinter;
+        CollectionUtils::MapFileTo<std::vector<fs::path>> unityGroups;
 
     public:
         TestMakefilesPrinter(const BaseTestGen *testGen,
@@ -41,6 +42,14 @@ namespace printer {
 
         void addStubs(const CollectionUtils::FileSet &stubsSet);
 
+        /**
+         * @brief Splits test files of the sources into groups compiled as single translation units.
+         *
+         * Only C sources with equal test compilation flags and without common method names are
+         * grouped, at most `--unity-build-size` in a group. Does nothing if unity build is off.
+         */
+        void addUnityGroups(const std::vector<fs::path> &sourcePaths);
+
         [[nodiscard]] TestMakefilesContent GetMakefiles(const fs::path &sourcePath);
     };
 }
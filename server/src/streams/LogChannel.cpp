@@ -0,0 +1,90 @@
+#include "LogChannel.h"
+
+#include "RequestEnvironment.h"
+
+#include <algorithm>
+#include <utility>
+
+LogChannel::LogChannel(std::string client, size_t capacity)
+    : client(std::move(client)), ring(std::max<size_t>(capacity, 1)) {
+}
+
+const std::string &LogChannel::getClient() const {
+    return client;
+}
+
+void LogChannel::push(std::string message) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) {
+            return;
+        }
+        if (size == ring.size()) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring[(head + size) % ring.size()] = std::move(message);
+        ++size;
+    }
+    messagesAvailable.notify_one();
+}
+
+void LogChannel::drainTo(grpc::ServerWriterInterface<testsgen::LogEntry> *writer) {
+    // the notice goes out as soon as the drainer notices drops, it doesn't wait until the
+    // messages logged before them are written
+    auto writeDroppedNotice = [this, writer]() {
+        uint64_t count = dropped.exchange(0, std::memory_order_relaxed);
+        if (count == 0) {
+            return true;
+        }
+        testsgen::LogEntry logEntry;
+        logEntry.set_message(std::to_string(count) +
+                             " log messages were dropped, the client reads logs too slowly\n");
+        return writer->Write(logEntry);
+    };
+    std::vector<std::string> batch;
+    while (true) {
+        bool lastBatch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // a disconnected client is noticed even if nothing is logged
+            while (!messagesAvailable.wait_for(lock, CANCELLATION_CHECK_INTERVAL, [this]() {
+                return closed || size > 0 || dropped.load(std::memory_order_relaxed) > 0;
+            })) {
+                if (RequestEnvironment::isCancelled()) {
+                    closed = true;
+                }
+            }
+            // messages logged before closing are still sent
+            lastBatch = closed;
+            batch.clear();
+            for (; size > 0; --size, head = (head + 1) % ring.size()) {
+                batch.push_back(std::move(ring[head]));
+            }
+        }
+        // nothing is logged here: the message would come back to this channel
+        if (!writeDroppedNotice()) {
+            close();
+            return;
+        }
+        testsgen::LogEntry logEntry;
+        for (auto &message : batch) {
+            logEntry.set_message(std::move(message));
+            if (!writer->Write(logEntry) || !writeDroppedNotice()) {
+                close();
+                return;
+            }
+        }
+        if (lastBatch) {
+            return;
+        }
+    }
+}
+
+void LogChannel::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    messagesAvailable.notify_all();
+}
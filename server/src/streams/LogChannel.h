@@ -0,0 +1,61 @@
+#ifndef UNITTESTBOT_LOGCHANNEL_H
+#define UNITTESTBOT_LOGCHANNEL_H
+
+#include <protobuf/testgen.grpc.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Log stream of a single client.
+ *
+ * Logging threads of the client only put messages into a bounded ring buffer, they never
+ * wait for the network. The thread of the streaming RPC drains the buffer into its writer in
+ * batches until the channel is closed or the client disconnects. When the client reads slower
+ * than the server logs, the newest messages are dropped and the client is told how many right
+ * after the message being written when the drops happen.
+ */
+class LogChannel {
+public:
+    LogChannel(std::string client, size_t capacity);
+
+    [[nodiscard]] const std::string &getClient() const;
+
+    /**
+     * @brief Enqueues the message, never blocks for long. Called from any thread.
+     */
+    void push(std::string message);
+
+    /**
+     * @brief Writes messages to the writer until the channel is closed, the writer fails or
+     * the request of the calling thread is cancelled. Messages queued before the channel is
+     * closed are written before returning.
+     */
+    void drainTo(grpc::ServerWriterInterface<testsgen::LogEntry> *writer);
+
+    void close();
+
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+private:
+    static constexpr std::chrono::milliseconds CANCELLATION_CHECK_INTERVAL{ 1000 };
+
+    const std::string client;
+
+    std::mutex mutex;
+    std::condition_variable messagesAvailable;
+    std::vector<std::string> ring;
+    size_t head = 0;
+    size_t size = 0;
+    // taken by the drainer between writes without the mutex
+    std::atomic<uint64_t> dropped = 0;
+    bool closed = false;
+};
+
+
+#endif // UNITTESTBOT_LOGCHANNEL_H
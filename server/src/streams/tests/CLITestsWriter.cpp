@@ -19,6 +19,7 @@ void CLITestsWriter::writeTestsWithProgress(tests::TestsMap &testMap,
             ++totalTestsCounter;
             LOG_S(INFO) << tests.testFilename << " test file generated";
         }
+        releaseIfNeeded(tests);
     }
     prepareTotal();
     LOG_S(INFO) << "total test files generated: " << totalTestsCounter;
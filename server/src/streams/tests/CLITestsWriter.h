@@ -8,7 +8,8 @@
 
 class CLITestsWriter : public TestsWriter {
 public:
-    explicit CLITestsWriter(): TestsWriter(nullptr) {};
+    explicit CLITestsWriter(bool releaseWrittenTests = false)
+        : TestsWriter(nullptr, releaseWrittenTests) {};
 
     void writeTestsWithProgress(tests::TestsMap &testMap,
                                 const std::string &message,
@@ -22,6 +22,7 @@ void ServerTestsWriter::writeTestsWithProgress(tests::TestsMap &testMap,
         if (writeFileAndSendResponse(tests, testDirPath, message, (100.0 * totalTestsCounter) / size, false)) {
             ++totalTestsCounter;
         }
+        releaseIfNeeded(tests);
     }
     prepareTotal();
     writeCompleted(testMap, totalTestsCounter);
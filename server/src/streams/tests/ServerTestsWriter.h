@@ -10,8 +10,9 @@
 class ServerTestsWriter : public TestsWriter {
 public:
     explicit ServerTestsWriter(grpc::ServerWriter<testsgen::TestsResponse> *writer,
-                               bool synchronizeCode)
-        : TestsWriter(writer), synchronizeCode(synchronizeCode)  {};
+                               bool synchronizeCode,
+                               bool releaseWrittenTests = false)
+        : TestsWriter(writer, releaseWrittenTests), synchronizeCode(synchronizeCode)  {};
 
     void writeTestsWithProgress(tests::TestsMap &testMap,
                                 const std::string &message,
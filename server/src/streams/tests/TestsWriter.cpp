@@ -6,7 +6,15 @@
 #include "loguru.h"
 
 
-TestsWriter::TestsWriter(grpc::ServerWriter<testsgen::TestsResponse> *writer): ServerWriter(writer) {}
+TestsWriter::TestsWriter(grpc::ServerWriter<testsgen::TestsResponse> *writer,
+                         bool releaseWrittenTests)
+    : ServerWriter(writer), releaseWrittenTests(releaseWrittenTests) {}
+
+void TestsWriter::releaseIfNeeded(tests::Tests &tests) const {
+    if (releaseWrittenTests) {
+        tests.releaseGeneratedCode();
+    }
+}
 
 void TestsWriter::writeCompleted(const tests::TestsMap &testMap, int totalTestsCounter) {
     std::string finalMessage;
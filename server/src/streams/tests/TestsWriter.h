@@ -12,7 +12,12 @@
 
 class TestsWriter : public utbot::ServerWriter<testsgen::TestsResponse> {
 public:
-    explicit TestsWriter(grpc::ServerWriter<testsgen::TestsResponse> *writer);
+    /**
+     * @param releaseWrittenTests free test cases and code of each file once it is written,
+     * see tests::Tests::releaseGeneratedCode. Only summaries of files are left for the caller.
+     */
+    explicit TestsWriter(grpc::ServerWriter<testsgen::TestsResponse> *writer,
+                         bool releaseWrittenTests = false);
 
     virtual void writeTestsWithProgress(tests::TestsMap &testMap,
                                         const std::string &message,
@@ -29,6 +34,10 @@ public:
 protected:
     void writeCompleted(tests::TestsMap const &testMap, int totalTestsCounter);
 
+    void releaseIfNeeded(tests::Tests &tests) const;
+
+    const bool releaseWrittenTests;
+
 };
 
 
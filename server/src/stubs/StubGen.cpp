@@ -3,8 +3,10 @@
 #include "FeaturesFilter.h"
 #include "Paths.h"
 #include "StubSourcesFinder.h"
+#include "StubsIndex.h"
 #include "Synchronizer.h"
 #include "TimeExecStatistics.h"
+#include "building/UndefinedSymbolsReader.h"
 #include "clang-utils/SourceToHeaderRewriter.h"
 #include "printers/CCJsonPrinter.h"
 #include "streams/stubs/StubsWriter.h"
@@ -36,24 +38,33 @@ StubGen::findStubFilesBySignatures(const std::vector<tests::Tests::MethodDescrip
     if (stubFiles.empty()) {
         return {};
     }
-    printer::CCJsonPrinter::createDummyBuildDB(stubFiles, ccJsonDirPath);
-    auto stubsCdb = CompilationUtils::getCompilationDatabase(ccJsonDirPath);
-    tests::TestsMap stubFilesMap;
-    for (const auto &file : stubFiles) {
-        stubFilesMap[file].sourceFilePath = file;
+    StubsIndex stubsIndex(testGen.projectContext);
+    auto notIndexedStubFiles = CollectionUtils::filterOut(
+        stubFiles, [&stubsIndex](fs::path const &stubPath) { return stubsIndex.isUpToDate(stubPath); });
+    if (!notIndexedStubFiles.empty()) {
+        // stubs are generated by Synchronizer and indexed there, so only ones edited by user
+        // or generated by older versions are parsed
+        printer::CCJsonPrinter::createDummyBuildDB(notIndexedStubFiles, ccJsonDirPath);
+        auto stubsCdb = CompilationUtils::getCompilationDatabase(ccJsonDirPath);
+        tests::TestsMap stubFilesMap;
+        for (const auto &file : notIndexedStubFiles) {
+            stubFilesMap[file].sourceFilePath = file;
+        }
+        Fetcher::Options::Value options = Fetcher::Options::Value::FUNCTION_NAMES_ONLY;
+        Fetcher fetcher(options, stubsCdb, stubFilesMap, nullptr, nullptr, ccJsonDirPath, true);
+        fetcher.fetchWithProgress(testGen.progressWriter, "Finding stub files", true);
+        for (const auto &[filePath, stub] : stubFilesMap) {
+            stubsIndex.update(filePath, CollectionUtils::getKeys(stub.methods));
+        }
+        stubsIndex.save();
     }
-    Fetcher::Options::Value options = Fetcher::Options::Value::FUNCTION_NAMES_ONLY;
-    Fetcher fetcher(options, stubsCdb, stubFilesMap, nullptr, nullptr, ccJsonDirPath, true);
-    fetcher.fetchWithProgress(testGen.progressWriter, "Finding stub files", true);
-    CollectionUtils::FileSet stubFilesSet;
     auto signatureNamesSet = CollectionUtils::transformTo<std::unordered_set<std::string>>(
         signatures,
         [&](const tests::Tests::MethodDescription &signature) { return signature.name; });
-    for (const auto &[filePath, stub] : stubFilesMap) {
-        for (const auto &[methodName, methodDescription] : stub.methods) {
-            if (CollectionUtils::contains(signatureNamesSet, methodName)) {
-                stubFilesSet.insert(filePath);
-            }
+    CollectionUtils::FileSet stubFilesSet;
+    for (const auto &stubPath : stubsIndex.findStubFiles(signatureNamesSet)) {
+        if (CollectionUtils::contains(stubFiles, stubPath)) {
+            stubFilesSet.insert(stubPath);
         }
     }
     return stubFilesSet;
@@ -101,20 +112,14 @@ bool StubGen::cmpMethodsDecl(const Tests::MethodDescription &decl1,
 }
 
 Result<CollectionUtils::FileSet> StubGen::getStubSetForObject(const fs::path &objectFilePath) {
-    ShellExecTask::ExecutionParameters nmCommand(
-            Paths::getLLVMnm(),
-            { "--print-file-name", "--undefined-only", "--just-symbol-name", objectFilePath });
-    auto [out, status, _] = ShellExecTask::runShellCommandTask(nmCommand, testGen.serverBuildDir);
-    if (status != 0) {
-        std::string errorMessage =
-                StringUtils::stringFormat("llvm-nm on %s failed: %s", objectFilePath, out);
+    auto result = UndefinedSymbolsReader::getInstance().read(objectFilePath);
+    if (!result.isSuccess()) {
+        std::string errorMessage = StringUtils::stringFormat(
+            "Reading undefined symbols of %s failed: %s", objectFilePath, result.getError().value());
         LOG_S(ERROR) << errorMessage;
         return errorMessage;
     }
-    auto symbols =
-            CollectionUtils::transform(StringUtils::split(out, '\n'), [](std::string const &line) {
-                return StringUtils::splitByWhitespaces(line).back();
-            });
+    auto symbols = result.getOpt().value();
     CollectionUtils::erase_if(symbols, [](std::string const &symbol) {
         return StringUtils::startsWith(symbol, "__ubsan") ||
                StringUtils::startsWith(symbol, "klee_");
@@ -0,0 +1,91 @@
+#include "StubsIndex.h"
+
+#include "Paths.h"
+#include "utils/JsonUtils.h"
+#include "utils/TimeUtils.h"
+
+#include "loguru.h"
+
+StubsIndex::StubsIndex(const utbot::ProjectContext &projectContext)
+    : indexPath(Paths::getStubsIndexPath(projectContext)),
+      stubsDirPath(Paths::getStubsDirPath(projectContext)) {
+    if (!fs::exists(indexPath)) {
+        return;
+    }
+    try {
+        auto json = JsonUtils::getJsonFromFile(indexPath);
+        for (const auto &[relativeStubPath, entryJson] : json.items()) {
+            addEntry(stubsDirPath / relativeStubPath,
+                     { entryJson.at("modificationTime").get<long long>(),
+                       entryJson.at("symbols").get<std::vector<std::string>>() });
+        }
+    } catch (const std::exception &e) {
+        // the index is only a cache, all stubs are parsed again
+        LOG_S(WARNING) << "Stubs index " << indexPath << " is broken: " << e.what();
+        entries.clear();
+        stubFilesBySymbol.clear();
+    }
+}
+
+void StubsIndex::update(const fs::path &stubPath, const std::vector<std::string> &symbols) {
+    remove(stubPath);
+    addEntry(stubPath, { getModificationTime(stubPath), symbols });
+}
+
+void StubsIndex::remove(const fs::path &stubPath) {
+    auto it = entries.find(stubPath);
+    if (it == entries.end()) {
+        return;
+    }
+    for (const auto &symbol : it->second.symbols) {
+        auto &stubFiles = stubFilesBySymbol[symbol];
+        stubFiles.erase(stubPath);
+        if (stubFiles.empty()) {
+            stubFilesBySymbol.erase(symbol);
+        }
+    }
+    entries.erase(it);
+}
+
+bool StubsIndex::isUpToDate(const fs::path &stubPath) const {
+    auto it = entries.find(stubPath);
+    return it != entries.end() && it->second.modificationTime == getModificationTime(stubPath);
+}
+
+CollectionUtils::FileSet
+StubsIndex::findStubFiles(const std::unordered_set<std::string> &symbols) const {
+    CollectionUtils::FileSet stubFiles;
+    for (const auto &symbol : symbols) {
+        auto it = stubFilesBySymbol.find(symbol);
+        if (it != stubFilesBySymbol.end()) {
+            stubFiles.insert(it->second.begin(), it->second.end());
+        }
+    }
+    return stubFiles;
+}
+
+void StubsIndex::save() const {
+    JsonUtils::json json = JsonUtils::json::object();
+    for (const auto &[stubPath, entry] : entries) {
+        json[fs::relative(stubPath, stubsDirPath).string()] = {
+            { "modificationTime", entry.modificationTime }, { "symbols", entry.symbols }
+        };
+    }
+    JsonUtils::writeJsonToFile(indexPath, json);
+}
+
+long long StubsIndex::getModificationTime(const fs::path &stubPath) {
+    std::error_code errorCode;
+    auto modificationTime = fs::last_write_time(stubPath, errorCode);
+    if (errorCode) {
+        return -1;
+    }
+    return TimeUtils::convertFileToSystemClock(modificationTime).time_since_epoch().count();
+}
+
+void StubsIndex::addEntry(const fs::path &stubPath, Entry entry) {
+    for (const auto &symbol : entry.symbols) {
+        stubFilesBySymbol[symbol].insert(stubPath);
+    }
+    entries[stubPath] = std::move(entry);
+}
@@ -0,0 +1,59 @@
+#ifndef UNITTESTBOT_STUBSINDEX_H
+#define UNITTESTBOT_STUBSINDEX_H
+
+#include "ProjectContext.h"
+#include "utils/CollectionUtils.h"
+
+#include "utils/path/FileSystemPath.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Persistent index of functions defined by stub files of a project.
+ *
+ * Synchronizer records functions of every stub it generates, so undefined symbols of an
+ * object are resolved to stub files by a lookup instead of parsing all stubs. An entry is
+ * valid while the stub file keeps the recorded modification time; stubs edited by user have
+ * to be parsed again and reindexed.
+ */
+class StubsIndex {
+public:
+    explicit StubsIndex(const utbot::ProjectContext &projectContext);
+
+    /**
+     * @brief Records functions of the stub file together with its current modification time.
+     */
+    void update(const fs::path &stubPath, const std::vector<std::string> &symbols);
+
+    void remove(const fs::path &stubPath);
+
+    [[nodiscard]] bool isUpToDate(const fs::path &stubPath) const;
+
+    /**
+     * @return indexed stub files defining any of the symbols.
+     */
+    [[nodiscard]] CollectionUtils::FileSet
+    findStubFiles(const std::unordered_set<std::string> &symbols) const;
+
+    void save() const;
+
+private:
+    struct Entry {
+        long long modificationTime;
+        std::vector<std::string> symbols;
+    };
+
+    static long long getModificationTime(const fs::path &stubPath);
+
+    void addEntry(const fs::path &stubPath, Entry entry);
+
+    fs::path indexPath;
+    fs::path stubsDirPath;
+    CollectionUtils::MapFileTo<Entry> entries;
+    std::unordered_map<std::string, CollectionUtils::FileSet> stubFilesBySymbol;
+};
+
+
+#endif // UNITTESTBOT_STUBSINDEX_H
@@ -0,0 +1,110 @@
+#include "ArtifactStore.h"
+
+#include "Paths.h"
+#include "commands/Commands.h"
+#include "exceptions/EnvironmentException.h"
+#include "utils/FileSystemUtils.h"
+
+#include "loguru.h"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MD5.h>
+
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+namespace {
+    /**
+     * Marks the stored file as recently used, so it is evicted last.
+     * @return false if there is no such file, e.g. it has been evicted.
+     */
+    bool touch(const fs::path &storedPath) {
+        std::error_code ec;
+        fs::last_write_time(storedPath, fs::file_time_type::clock::now(), ec);
+        return !ec;
+    }
+}
+
+ArtifactStore::ArtifactStore()
+    : root(Commands::artifactStorePath.empty() ? Paths::getDefaultArtifactStoreDir()
+                                               : Commands::artifactStorePath) {
+}
+
+ArtifactStore &ArtifactStore::getInstance() {
+    // never destroyed: forked children call exit() while other threads may use the store
+    static auto *instance = new ArtifactStore();
+    return *instance;
+}
+
+std::string ArtifactStore::put(const fs::path &filePath) {
+    auto modificationTime = fs::last_write_time(filePath);
+    auto size = fs::file_size(filePath);
+    std::string key;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(filePath.string());
+        if (it != entries.end() && it->second.modificationTime == modificationTime &&
+            it->second.size == size) {
+            key = it->second.key;
+        }
+    }
+    // the stored file may have been evicted since the key was computed
+    if (!key.empty() && touch(root / key)) {
+        return key;
+    }
+    std::ifstream stream(filePath, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    if (!stream) {
+        throw EnvironmentException("Couldn't read " + filePath.string());
+    }
+    llvm::MD5 hash;
+    hash.update(llvm::StringRef(content));
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    key = result.digest().str().str() + "_" + std::to_string(content.size());
+    fs::path storedPath = root / key;
+    if (!touch(storedPath)) {
+        fs::create_directories(root);
+        static std::atomic<uint64_t> nextTmpId = 0;
+        fs::path tmpPath = root / (key + "_" + std::to_string(getpid()) + "_" +
+                                   std::to_string(nextTmpId++) + ".tmp");
+        std::ofstream out(tmpPath, std::ios::binary);
+        out << content;
+        out.close();
+        if (!out) {
+            throw EnvironmentException("Couldn't write " + tmpPath.string());
+        }
+        fs::rename(tmpPath, storedPath);
+        LOG_S(DEBUG) << "Stored " << filePath << " as " << key;
+        evict();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[filePath.string()] = { modificationTime, size, key };
+    return key;
+}
+
+std::optional<fs::path> ArtifactStore::get(const std::string &key) const {
+    // keys come from other processes, they must not point outside the store
+    if (key.empty() || key.find('/') != std::string::npos || key.find("..") != std::string::npos) {
+        return std::nullopt;
+    }
+    fs::path storedPath = root / key;
+    if (!fs::exists(storedPath)) {
+        return std::nullopt;
+    }
+    // the store may be mounted read-only on the worker, then it is just not marked
+    touch(storedPath);
+    return storedPath;
+}
+
+void ArtifactStore::evict() const {
+    if (Commands::artifactStoreSize == 0) {
+        return;
+    }
+    // files in use are the most recently touched ones, so they are removed last
+    uintmax_t capacity = static_cast<uintmax_t>(Commands::artifactStoreSize) << 20;
+    size_t evicted = FileSystemUtils::evictLeastRecentlyUsed(root, capacity);
+    LOG_IF_S(DEBUG, evicted > 0) << "Evicted " << evicted << " files from artifact store " << root;
+}
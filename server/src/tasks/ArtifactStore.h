@@ -0,0 +1,55 @@
+#ifndef UNITTESTBOT_ARTIFACTSTORE_H
+#define UNITTESTBOT_ARTIFACTSTORE_H
+
+#include "utils/path/FileSystemPath.h"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Content-addressed store of files shared by the server and its KLEE workers.
+ *
+ * A file is stored under the key made of the MD5 digest and the size of its content and is
+ * published with an atomic rename, so workers see either the whole file or nothing. The
+ * directory is `--artifact-store`, for workers on other hosts it has to be a shared mount.
+ * Every put and get marks the file as used, least recently used files are evicted when
+ * the store exceeds `--artifact-store-size`.
+ */
+class ArtifactStore {
+public:
+    static ArtifactStore &getInstance();
+
+    /**
+     * @brief Copies the file to the store unless it is already there.
+     * @return key of the file content.
+     */
+    std::string put(const fs::path &filePath);
+
+    /**
+     * @return path of the stored file or std::nullopt if there is no such key.
+     */
+    [[nodiscard]] std::optional<fs::path> get(const std::string &key) const;
+
+private:
+    struct Entry {
+        fs::file_time_type modificationTime;
+        uintmax_t size;
+        std::string key;
+    };
+
+    ArtifactStore();
+
+    void evict() const;
+
+    const fs::path root;
+
+    std::mutex mutex;
+    // keys of files already put, so unchanged bitcode isn't read again for every method
+    std::unordered_map<std::string, Entry> entries;
+};
+
+
+#endif // UNITTESTBOT_ARTIFACTSTORE_H
@@ -1,5 +1,7 @@
 #include "BaseForkTask.h"
+#include "JobScheduler.h"
 #include "RequestEnvironment.h"
+#include "TimeExecStatistics.h"
 #include "exceptions/BaseException.h"
 #include "utils/ExecUtils.h"
 #include "utils/StringFormat.h"
@@ -8,6 +10,7 @@
 
 #include <grpc/impl/codegen/fork.h>
 
+#include <algorithm>
 #include <thread>
 #include <utility>
 
@@ -37,6 +40,7 @@ BaseForkTask::BaseForkTask(std::string processName,
 }
 
 ExecUtils::ExecutionResult BaseForkTask::run() {
+    auto slot = JobScheduler::getInstance().acquire();
     grpc_prefork();
     switch (pid = fork()) {
         case -1: {
@@ -64,7 +68,13 @@ ExecUtils::ExecutionResult BaseForkTask::run() {
             // This is parent process
             LOG_S(DEBUG) << "Running " << processName << " out of process from pid: " << getpid();
             initMessage();
-            int status = waitForFinishedOrCancelled();
+            onChildStarted();
+            int status;
+            {
+                const TimeExecStatistics childProcessStats(
+                    TimeExecStatistics::getProcessCallSite(processName), processName);
+                status = waitForFinishedOrCancelled();
+            }
             std::string output = collectAndCleanup();
             if (cancelled) {
                 status = TIMEOUT_CODE;
@@ -109,6 +119,9 @@ void BaseForkTask::redirectMessage() const {
 void BaseForkTask::initMessage() const {
 }
 
+void BaseForkTask::onChildStarted() {
+}
+
 
 bool BaseForkTask::redirectOutput() {
     redirectMessage();
@@ -165,8 +178,14 @@ int BaseForkTask::waitForFinishedOrCancelled() {
                     sendSignals = true;
                 }
             }
-            if (RequestEnvironment::isCancelled()) {
+            if (!cancellationDeadline.has_value() && RequestEnvironment::isCancelled()) {
                 LOG_S(DEBUG) << "Stopping " << processName << " as cancellation was received";
+                cancellationDeadline = std::chrono::steady_clock::now() + CANCELLATION_TIMEOUT;
+                sendSignals = true;
+            }
+            if (!sendSignals && std::any_of(stopFlags.begin(), stopFlags.end(),
+                                            [](const std::atomic_bool *flag) { return flag->load(); })) {
+                LOG_S(DEBUG) << "Stopping " << processName << " as it was requested by its owner";
                 sendSignals = true;
             }
             if (sendSignals) {
@@ -225,6 +244,24 @@ int BaseForkTask::waitForFinishedOrCancelled() {
     }
 }
 
+bool BaseForkTask::waitForExit(std::chrono::milliseconds waitTimeout) const {
+    auto deadline = std::chrono::steady_clock::now() + waitTimeout;
+    if (cancellationDeadline.has_value()) {
+        deadline = std::min(deadline, cancellationDeadline.value());
+    }
+    while (true) {
+        siginfo_t info{};
+        // WNOWAIT leaves the process to waitForFinishedOrCancelled, which takes its status
+        if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0 || info.si_pid == pid) {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(EXIT_CHECK_INTERVAL);
+    }
+}
+
 void BaseForkTask::setLogFilePath(fs::path path) {
     logFilePath = std::move(path);
 }
@@ -232,3 +269,7 @@ void BaseForkTask::setLogFilePath(fs::path path) {
 void BaseForkTask::setRetainOutputFile(bool retain) {
     retainOutputFile = retain;
 }
+
+void BaseForkTask::addStopFlag(const std::atomic_bool *flag) {
+    stopFlags.push_back(flag);
+}
@@ -7,7 +7,10 @@
 #include <protobuf/testgen.grpc.pb.h>
 #include <run_klee/run_klee.h>
 
+#include <atomic>
+#include <chrono>
 #include <fcntl.h>
+#include <optional>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -29,6 +32,12 @@ public:
      * be retained in all cases.
      */
     void setRetainOutputFile(bool retain);
+    /**
+     * @brief Adds a flag which stops the task the same way as
+     * cancellation does once it is raised by another thread.
+     * @param flag - the flag owned by the caller, it must outlive the task.
+     */
+    void addStopFlag(const std::atomic_bool *flag);
     /**
      * @brief Checks if the task was interrupted via its exit code.
      * @param exitCode - the task exit code.
@@ -77,6 +86,12 @@ protected:
      */
     virtual void initMessage() const;
 
+    /**
+     * @brief Triggers in parent process right after the child
+     * process is created.
+     */
+    virtual void onChildStarted();
+
     /**
      * @brief Triggers after sending signal to child process.
      */
@@ -110,6 +125,13 @@ protected:
      */
     int waitForFinishedOrCancelled();
 
+    /**
+     * @brief Waits until the child process exits, but not longer than the given time and
+     * not after the deadline set by cancellation. The process is not reaped.
+     * @return true if the process has exited.
+     */
+    bool waitForExit(std::chrono::milliseconds waitTimeout) const;
+
     /**
      * Pid of the child process, used to track its status.
      */
@@ -151,6 +173,21 @@ protected:
      * Should output file be retained on exit code 0.
      */
     bool retainOutputFile = false;
+    /**
+     * Externally owned flags, any of which requests the task to stop.
+     */
+    std::vector<const std::atomic_bool *> stopFlags;
+    /**
+     * Time by which the child process of a cancelled request has to be stopped.
+     * Waits after shutdown signals are cut short by it.
+     */
+    std::optional<std::chrono::steady_clock::time_point> cancellationDeadline;
+    /**
+     * Results of a cancelled request are thrown away, so its child process is given
+     * only this time to stop gracefully.
+     */
+    static constexpr std::chrono::milliseconds CANCELLATION_TIMEOUT{ 1'000 };
+    static constexpr std::chrono::milliseconds EXIT_CHECK_INTERVAL{ 10 };
     /**
      * Exit codes set by child process to indicate
      * special errors.
@@ -0,0 +1,165 @@
+#include "JobScheduler.h"
+
+#include "commands/Commands.h"
+#include "streams/ProgressWriter.h"
+#include "utils/ExecUtils.h"
+
+#include "loguru.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+    // slots held by the current thread, nested jobs run in the slot of the outer one
+    thread_local size_t heldSlots = 0;
+}
+
+JobScheduler::Slot::Slot(std::string clientId) : clientId(std::move(clientId)) {
+    ++heldSlots;
+}
+
+JobScheduler::Slot::Slot(Slot &&other) noexcept : clientId(std::move(other.clientId)) {
+    other.clientId = std::nullopt;
+}
+
+JobScheduler::Slot &JobScheduler::Slot::operator=(Slot &&other) noexcept {
+    if (this != &other) {
+        if (clientId.has_value()) {
+            --heldSlots;
+            JobScheduler::getInstance().release(clientId.value());
+        }
+        clientId = std::move(other.clientId);
+        other.clientId = std::nullopt;
+    }
+    return *this;
+}
+
+JobScheduler::Slot::~Slot() {
+    if (clientId.has_value()) {
+        --heldSlots;
+        JobScheduler::getInstance().release(clientId.value());
+    }
+}
+
+JobScheduler::InheritedSlot::InheritedSlot(bool inherit) : inherit(inherit) {
+    if (inherit) {
+        ++heldSlots;
+    }
+}
+
+JobScheduler::InheritedSlot::~InheritedSlot() {
+    if (inherit) {
+        --heldSlots;
+    }
+}
+
+bool JobScheduler::holdsSlot() {
+    return heldSlots > 0;
+}
+
+JobScheduler &JobScheduler::getInstance() {
+    // never destroyed: forked children call exit() while other threads may hold slots
+    static auto *instance = new JobScheduler();
+    return *instance;
+}
+
+JobScheduler::Slot JobScheduler::acquire() {
+    if (heldSlots > 0) {
+        return {};
+    }
+    const ProgressWriter *progressWriter = RequestEnvironment::getProgressWriter();
+    std::unique_lock<std::mutex> lock(mutex);
+    auto waiter = waiters.insert(waiters.end(),
+                                 { nextTicket++, RequestEnvironment::clientId.value_or(""),
+                                   RequestEnvironment::getPriority() });
+    std::optional<size_t> reportedPosition;
+    while (true) {
+        size_t position = getQueuePosition(*waiter);
+        if (runningJobsCount < getCapacity() && position == 0) {
+            break;
+        }
+        if (reportedPosition != position) {
+            size_t jobsAhead = position + (runningJobsCount >= getCapacity() ? 1 : 0);
+            LOG_S(DEBUG) << "Job is queued, " << jobsAhead << " job(s) ahead";
+            if (progressWriter != nullptr) {
+                progressWriter->writeProgress("Waiting in server queue: " +
+                                              std::to_string(jobsAhead) + " job(s) ahead");
+            }
+            reportedPosition = position;
+        }
+        slotReleased.wait_for(lock, CANCELLATION_CHECK_INTERVAL);
+        lock.unlock();
+        try {
+            ExecUtils::throwIfCancelled();
+        } catch (...) {
+            lock.lock();
+            waiters.erase(waiter);
+            lock.unlock();
+            slotReleased.notify_all();
+            throw;
+        }
+        lock.lock();
+    }
+    std::string clientId = waiter->clientId;
+    waiters.erase(waiter);
+    ++runningJobs[clientId];
+    ++runningJobsCount;
+    // the next waiter may fit into the budget as well
+    slotReleased.notify_all();
+    return Slot(std::move(clientId));
+}
+
+std::optional<JobScheduler::Slot> JobScheduler::tryAcquire() {
+    if (heldSlots > 0) {
+        return Slot();
+    }
+    std::string clientId = RequestEnvironment::clientId.value_or("");
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (runningJobsCount >= getCapacity() || !waiters.empty()) {
+            return std::nullopt;
+        }
+        ++runningJobs[clientId];
+        ++runningJobsCount;
+    }
+    return Slot(std::move(clientId));
+}
+
+void JobScheduler::release(const std::string &clientId) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--runningJobs[clientId] == 0) {
+            runningJobs.erase(clientId);
+        }
+        --runningJobsCount;
+    }
+    slotReleased.notify_all();
+}
+
+size_t JobScheduler::getCapacity() const {
+    if (Commands::maxJobs != 0) {
+        return Commands::maxJobs;
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+size_t JobScheduler::getQueuePosition(const Waiter &waiter) const {
+    return std::count_if(waiters.begin(), waiters.end(),
+                         [this, &waiter](const Waiter &other) { return precedes(other, waiter); });
+}
+
+bool JobScheduler::precedes(const Waiter &lhs, const Waiter &rhs) const {
+    if (lhs.priority != rhs.priority) {
+        return lhs.priority < rhs.priority;
+    }
+    auto getRunning = [this](const std::string &clientId) -> size_t {
+        auto it = runningJobs.find(clientId);
+        return it == runningJobs.end() ? 0 : it->second;
+    };
+    size_t lhsRunning = getRunning(lhs.clientId);
+    size_t rhsRunning = getRunning(rhs.clientId);
+    if (lhsRunning != rhsRunning) {
+        return lhsRunning < rhsRunning;
+    }
+    return lhs.ticket < rhs.ticket;
+}
@@ -0,0 +1,123 @@
+#ifndef UNITTESTBOT_JOBSCHEDULER_H
+#define UNITTESTBOT_JOBSCHEDULER_H
+
+#include "RequestEnvironment.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Server-wide limit on heavy jobs of all clients.
+ *
+ * Every forked task (KLEE, make, compilers, coverage tools) and every worker thread of
+ * parallel generation takes a slot before it starts. At most `--max-jobs` slots are taken at
+ * once. When a slot is released, it goes to a waiting job of the highest priority (see
+ * RequestEnvironment::Priority); among them, to the client running the fewest jobs, so a
+ * project run of one client doesn't starve the others. A waiting job reports its position
+ * in the queue through the progress writer of the request.
+ *
+ * A thread that already holds a slot doesn't take another one, e.g. for a fork made by a
+ * parallel generation worker. Memory of KLEE runs is governed by KleeMemoryGovernor.
+ */
+class JobScheduler {
+    struct Waiter {
+        uint64_t ticket;
+        std::string clientId;
+        RequestEnvironment::Priority priority;
+    };
+
+public:
+    /**
+     * A taken slot. It is released on destruction, which must happen on the same thread.
+     */
+    class Slot {
+    public:
+        Slot() = default;
+        Slot(const Slot &) = delete;
+        Slot &operator=(const Slot &) = delete;
+        Slot(Slot &&other) noexcept;
+        Slot &operator=(Slot &&other) noexcept;
+        ~Slot();
+
+    private:
+        friend class JobScheduler;
+
+        explicit Slot(std::string clientId);
+
+        std::optional<std::string> clientId;
+    };
+
+    /**
+     * Lets a helper thread of a job run in the slot of that job, e.g. KLEE runs of a searcher
+     * portfolio started by a parallel generation worker. While it lives, jobs of the thread
+     * don't take slots of their own, so the helpers can't wait for the slot their job holds.
+     * It must be destroyed on the same thread.
+     */
+    class InheritedSlot {
+    public:
+        /**
+         * @param inherit whether the job which started the thread holds a slot, see holdsSlot.
+         */
+        explicit InheritedSlot(bool inherit);
+        InheritedSlot(const InheritedSlot &) = delete;
+        InheritedSlot &operator=(const InheritedSlot &) = delete;
+        ~InheritedSlot();
+
+    private:
+        const bool inherit;
+    };
+
+    static JobScheduler &getInstance();
+
+    /**
+     * @return whether the current thread holds a slot.
+     */
+    static bool holdsSlot();
+
+    /**
+     * @brief Blocks until the job of the current request may start.
+     * @return empty slot if the thread already holds one.
+     * @throws CancellationException if the request is cancelled while waiting.
+     */
+    Slot acquire();
+
+    /**
+     * @brief Takes a slot without waiting, e.g. for an optional helper of a job which can't
+     * wait for slots while its job holds one.
+     * @return empty slot if the thread already holds one, std::nullopt if all slots are
+     * taken or other jobs wait for them.
+     */
+    std::optional<Slot> tryAcquire();
+
+private:
+    JobScheduler() = default;
+
+    void release(const std::string &clientId);
+
+    [[nodiscard]] size_t getCapacity() const;
+
+    /**
+     * @return number of waiters that get a slot before the given one.
+     */
+    [[nodiscard]] size_t getQueuePosition(const Waiter &waiter) const;
+
+    [[nodiscard]] bool precedes(const Waiter &lhs, const Waiter &rhs) const;
+
+    static constexpr std::chrono::milliseconds CANCELLATION_CHECK_INTERVAL{ 100 };
+
+    mutable std::mutex mutex;
+    std::condition_variable slotReleased;
+    std::list<Waiter> waiters;
+    std::unordered_map<std::string, size_t> runningJobs;
+    size_t runningJobsCount = 0;
+    uint64_t nextTicket = 0;
+};
+
+
+#endif // UNITTESTBOT_JOBSCHEDULER_H
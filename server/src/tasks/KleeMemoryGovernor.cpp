@@ -0,0 +1,203 @@
+#include "KleeMemoryGovernor.h"
+
+#include "commands/Commands.h"
+#include "utils/CollectionUtils.h"
+#include "utils/ExecUtils.h"
+#include "utils/StringUtils.h"
+
+#include "loguru.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+KleeMemoryGovernor::Admission::Admission(std::list<Run>::iterator run) : run(run) {
+}
+
+KleeMemoryGovernor::Admission::Admission(Admission &&other) noexcept : run(other.run) {
+    other.run = std::nullopt;
+}
+
+KleeMemoryGovernor::Admission &
+KleeMemoryGovernor::Admission::operator=(Admission &&other) noexcept {
+    if (this != &other) {
+        if (run.has_value()) {
+            KleeMemoryGovernor::getInstance().release(run.value());
+        }
+        run = other.run;
+        other.run = std::nullopt;
+    }
+    return *this;
+}
+
+KleeMemoryGovernor::Admission::~Admission() {
+    if (run.has_value()) {
+        KleeMemoryGovernor::getInstance().release(run.value());
+    }
+}
+
+std::optional<uint64_t> KleeMemoryGovernor::Admission::getMaxMemoryMegabytes() const {
+    if (!run.has_value()) {
+        return std::nullopt;
+    }
+    return run.value()->reservedMegabytes;
+}
+
+const std::atomic_bool *KleeMemoryGovernor::Admission::getStopFlag() const {
+    if (!run.has_value()) {
+        return nullptr;
+    }
+    return &run.value()->stopFlag;
+}
+
+void KleeMemoryGovernor::Admission::attach(pid_t pgid) {
+    if (run.has_value()) {
+        KleeMemoryGovernor::getInstance().attach(run.value(), pgid);
+    }
+}
+
+KleeMemoryGovernor &KleeMemoryGovernor::getInstance() {
+    // never destroyed: forked children call exit() and must not wait for the watcher thread
+    static auto *instance = new KleeMemoryGovernor();
+    return *instance;
+}
+
+KleeMemoryGovernor::Admission KleeMemoryGovernor::admit() {
+    const uint64_t budget = Commands::kleeMemoryBudget;
+    if (budget == 0) {
+        return {};
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!watcherStarted) {
+        std::thread(&KleeMemoryGovernor::watch, this).detach();
+        watcherStarted = true;
+    }
+    bool waitLogged = false;
+    while (true) {
+        uint64_t projected = getProjectedMegabytes();
+        uint64_t available = budget > projected ? budget - projected : 0;
+        uint64_t reserved = std::min(available, DEFAULT_MAX_MEMORY_MEGABYTES);
+        // a single run is always admitted, otherwise it would wait forever
+        if (runs.empty()) {
+            reserved = std::max(reserved, std::min(budget, DEFAULT_MAX_MEMORY_MEGABYTES));
+        }
+        if (reserved >= MIN_MAX_MEMORY_MEGABYTES || runs.empty()) {
+            LOG_IF_S(DEBUG, reserved < DEFAULT_MAX_MEMORY_MEGABYTES)
+                << "KLEE is admitted with reduced max memory: " << reserved << "MB";
+            runs.emplace_back(nextRunId++, reserved);
+            return Admission(std::prev(runs.end()));
+        }
+        LOG_IF_S(DEBUG, !waitLogged) << "Waiting for memory to run KLEE, projected usage: "
+                                     << projected << "MB of " << budget << "MB";
+        waitLogged = true;
+        budgetReleased.wait_for(lock, CANCELLATION_CHECK_INTERVAL);
+        lock.unlock();
+        ExecUtils::throwIfCancelled();
+        lock.lock();
+    }
+}
+
+void KleeMemoryGovernor::release(std::list<Run>::iterator run) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        runs.erase(run);
+    }
+    budgetReleased.notify_all();
+}
+
+void KleeMemoryGovernor::attach(std::list<Run>::iterator run, pid_t pgid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    run->pgid = pgid;
+}
+
+uint64_t KleeMemoryGovernor::getProjectedMegabytes() const {
+    uint64_t projected = 0;
+    for (const auto &run : runs) {
+        projected += std::max(run.rssMegabytes, run.reservedMegabytes);
+    }
+    return projected;
+}
+
+void KleeMemoryGovernor::watch() {
+    loguru::set_thread_name("klee memory governor");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        std::vector<std::pair<uint64_t, pid_t>> attached;
+        for (const auto &run : runs) {
+            if (run.pgid.has_value()) {
+                attached.emplace_back(run.id, run.pgid.value());
+            }
+        }
+        // reading /proc is slow, so it is done without blocking admissions
+        lock.unlock();
+        std::unordered_map<uint64_t, uint64_t> usage;
+        for (const auto &[id, pgid] : attached) {
+            usage[id] = getProcessGroupRssMegabytes(pgid);
+        }
+        lock.lock();
+
+        uint64_t total = 0;
+        Run *largest = nullptr;
+        // runs finished while their memory was measured are already gone
+        for (auto &run : runs) {
+            if (!CollectionUtils::containsKey(usage, run.id)) {
+                continue;
+            }
+            run.rssMegabytes = usage[run.id];
+            total += run.rssMegabytes;
+            if (!run.stopFlag && (largest == nullptr || largest->rssMegabytes < run.rssMegabytes)) {
+                largest = &run;
+            }
+        }
+        if (total > Commands::kleeMemoryBudget && largest != nullptr) {
+            LOG_S(WARNING) << "KLEE processes use " << total << "MB of "
+                           << Commands::kleeMemoryBudget << "MB budget, stopping the largest one";
+            largest->stopFlag = true;
+        }
+        budgetReleased.wait_for(lock, POLL_INTERVAL);
+    }
+}
+
+uint64_t KleeMemoryGovernor::getProcessGroupRssMegabytes(pid_t pgid) {
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    uint64_t rssPages = 0;
+    std::unique_ptr<DIR, decltype(&closedir)> proc(opendir("/proc"), closedir);
+    if (proc == nullptr) {
+        return 0;
+    }
+    while (dirent *entry = readdir(proc.get())) {
+        if (!StringUtils::isNumber(entry->d_name)) {
+            continue;
+        }
+        std::ifstream statFile(std::string("/proc/") + entry->d_name + "/stat");
+        std::string stat;
+        if (!std::getline(statFile, stat)) {
+            continue;
+        }
+        // process name may contain spaces, so fields are counted from its closing bracket
+        size_t nameEnd = stat.rfind(')');
+        if (nameEnd == std::string::npos) {
+            continue;
+        }
+        std::istringstream fields(stat.substr(nameEnd + 1));
+        std::string state;
+        pid_t ppid = 0, pgrp = 0;
+        fields >> state >> ppid >> pgrp;
+        if (pgrp != pgid) {
+            continue;
+        }
+        // rss is the 24th field of stat, pgrp is the 5th one
+        std::string skipped;
+        for (int i = 0; i < 18 && fields >> skipped; i++) {
+        }
+        uint64_t pages = 0;
+        if (fields >> pages) {
+            rssPages += pages;
+        }
+    }
+    return rssPages * static_cast<uint64_t>(pageSize) >> 20;
+}
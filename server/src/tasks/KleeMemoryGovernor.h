@@ -0,0 +1,118 @@
+#ifndef UNITTESTBOT_KLEEMEMORYGOVERNOR_H
+#define UNITTESTBOT_KLEEMEMORYGOVERNOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include <sys/types.h>
+
+/**
+ * Server-wide admission control for KLEE processes.
+ *
+ * Every RunKleeTask asks the governor for admission before fork. A run is admitted only if
+ * the live RSS of already running KLEE process groups plus memory reserved for them fits
+ * into `--klee-memory-budget`. If the budget is tight, the run is admitted with a lower KLEE
+ * `--max-memory`; if even the minimal amount does not fit, the run waits. A watcher thread
+ * polls RSS of running groups from /proc and gracefully stops the largest run whenever the
+ * total goes over the budget, so it still dumps its ktests.
+ *
+ * The governor is disabled when the budget is 0.
+ */
+class KleeMemoryGovernor {
+    struct Run {
+        uint64_t id;
+        uint64_t reservedMegabytes;
+        std::optional<pid_t> pgid;
+        uint64_t rssMegabytes = 0;
+        std::atomic_bool stopFlag = false;
+
+        Run(uint64_t id, uint64_t reservedMegabytes) : id(id), reservedMegabytes(reservedMegabytes) {}
+    };
+
+public:
+    /**
+     * Reservation of memory for a single KLEE run. Memory is released on destruction.
+     */
+    class Admission {
+    public:
+        Admission() = default;
+        Admission(const Admission &) = delete;
+        Admission &operator=(const Admission &) = delete;
+        Admission(Admission &&other) noexcept;
+        Admission &operator=(Admission &&other) noexcept;
+        ~Admission();
+
+        /**
+         * @return value for KLEE `--max-memory` option or std::nullopt if the governor is
+         * disabled.
+         */
+        [[nodiscard]] std::optional<uint64_t> getMaxMemoryMegabytes() const;
+
+        /**
+         * @return flag raised by the governor when the run has to be stopped.
+         */
+        [[nodiscard]] const std::atomic_bool *getStopFlag() const;
+
+        /**
+         * @brief Starts tracking RSS of the process group of the started child.
+         */
+        void attach(pid_t pgid);
+
+    private:
+        friend class KleeMemoryGovernor;
+
+        explicit Admission(std::list<Run>::iterator run);
+
+        std::optional<std::list<Run>::iterator> run;
+    };
+
+    static KleeMemoryGovernor &getInstance();
+
+    /**
+     * @brief Blocks until the budget allows one more KLEE run.
+     * @throws CancellationException if the request is cancelled while waiting.
+     */
+    Admission admit();
+
+    /**
+     * @brief Reads total RSS of all processes of the group from /proc.
+     */
+    static uint64_t getProcessGroupRssMegabytes(pid_t pgid);
+
+private:
+    KleeMemoryGovernor() = default;
+
+    void release(std::list<Run>::iterator run);
+
+    void attach(std::list<Run>::iterator run, pid_t pgid);
+
+    void watch();
+
+    [[nodiscard]] uint64_t getProjectedMegabytes() const;
+
+    /**
+     * Memory KLEE uses by default, it is reserved for every run if the budget allows.
+     */
+    static constexpr uint64_t DEFAULT_MAX_MEMORY_MEGABYTES = 2000;
+    /**
+     * KLEE runs with less memory are not started at all.
+     */
+    static constexpr uint64_t MIN_MAX_MEMORY_MEGABYTES = 256;
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{ 1000 };
+    static constexpr std::chrono::milliseconds CANCELLATION_CHECK_INTERVAL{ 100 };
+
+    mutable std::mutex mutex;
+    std::condition_variable budgetReleased;
+    std::list<Run> runs;
+    uint64_t nextRunId = 0;
+    bool watcherStarted = false;
+};
+
+
+#endif // UNITTESTBOT_KLEEMEMORYGOVERNOR_H
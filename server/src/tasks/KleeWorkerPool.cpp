@@ -0,0 +1,163 @@
+#include "KleeWorkerPool.h"
+
+#include "ArtifactStore.h"
+#include "RequestEnvironment.h"
+#include "commands/Commands.h"
+#include "utils/ExecUtils.h"
+#include "utils/FileSystemUtils.h"
+#include "utils/StringUtils.h"
+
+#include "loguru.h"
+
+#include <algorithm>
+#include <future>
+
+namespace {
+    // options referring to files of this server, the worker can't use them
+    const std::vector<std::string> LOCAL_OPTION_PREFIXES = {
+        "--output-dir=", "--seed-dir=", "--allow-seed-extension", "--allow-seed-truncation"
+    };
+}
+
+KleeWorkerPool::KleeWorkerPool() {
+    setWorkers(Commands::kleeWorkers);
+}
+
+KleeWorkerPool &KleeWorkerPool::getInstance() {
+    // never destroyed: forked children call exit() while other threads may wait for workers
+    static auto *instance = new KleeWorkerPool();
+    return *instance;
+}
+
+bool KleeWorkerPool::isEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !workers.empty();
+}
+
+void KleeWorkerPool::setWorkers(const std::vector<std::string> &addresses) {
+    grpc::ChannelArguments arguments;
+    // KLEE output directories easily exceed the default limit of 4 MB
+    arguments.SetMaxReceiveMessageSize(-1);
+    std::vector<Worker> newWorkers;
+    for (const std::string &address : addresses) {
+        auto channel =
+            grpc::CreateCustomChannel(address, grpc::InsecureChannelCredentials(), arguments);
+        newWorkers.push_back({ address, testsgen::KleeWorkerService::NewStub(channel) });
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    workers = std::move(newWorkers);
+}
+
+std::optional<ExecUtils::ExecutionResult>
+KleeWorkerPool::run(const std::vector<std::string> &argvData,
+                    const fs::path &bitcodeFilePath,
+                    const fs::path &kleeOut,
+                    const std::optional<std::chrono::seconds> &timeout,
+                    const std::atomic_bool *stopFlag) {
+    testsgen::KleeRunRequest request = createRequest(argvData, bitcodeFilePath, timeout);
+    Worker *acquired = acquireWorker();
+    if (acquired == nullptr) {
+        LOG_S(DEBUG) << "All KLEE workers are down, running KLEE for " << bitcodeFilePath
+                     << " locally";
+        return std::nullopt;
+    }
+    Worker &worker = *acquired;
+    LOG_S(DEBUG) << "Running KLEE for " << bitcodeFilePath << " on worker " << worker.address;
+
+    grpc::ClientContext context;
+    context.AddMetadata("clientid", RequestEnvironment::getClientId());
+    if (timeout.has_value()) {
+        context.set_deadline(std::chrono::system_clock::now() + timeout.value() +
+                             DEADLINE_MARGIN);
+    }
+    testsgen::KleeRunResponse response;
+    auto call = std::async(std::launch::async, [&]() {
+        return worker.stub->RunKlee(&context, request, &response);
+    });
+    while (call.wait_for(CANCELLATION_CHECK_INTERVAL) != std::future_status::ready) {
+        if (RequestEnvironment::isCancelled() || (stopFlag != nullptr && *stopFlag)) {
+            context.TryCancel();
+        }
+    }
+    grpc::Status status = call.get();
+    bool stopped = stopFlag != nullptr && *stopFlag;
+    // a call cancelled by the request or by the owner says nothing about the worker
+    bool failed = !status.ok() && !RequestEnvironment::isCancelled() && !stopped;
+    releaseWorker(worker, failed);
+    ExecUtils::throwIfCancelled();
+    if (!status.ok() && stopped) {
+        LOG_S(DEBUG) << "KLEE run for " << bitcodeFilePath << " on worker " << worker.address
+                     << " was stopped by its owner";
+        return ExecUtils::ExecutionResult{ "", -1, std::nullopt };
+    }
+    if (!status.ok()) {
+        LOG_S(WARNING) << "KLEE worker " << worker.address << " failed to run KLEE: "
+                       << status.error_message() << ", it gets no runs for "
+                       << RETRY_DELAY.count() << " seconds";
+        return std::nullopt;
+    }
+
+    fs::create_directories(kleeOut);
+    for (const auto &file : response.files()) {
+        // names come from another process, they must not point outside the directory
+        fs::path fileName = fs::path(file.name()).filename();
+        if (fileName.empty() || fileName == "." || fileName == "..") {
+            continue;
+        }
+        FileSystemUtils::writeToFile(kleeOut / fileName, file.content());
+    }
+    return ExecUtils::ExecutionResult{ "", response.status(), std::nullopt };
+}
+
+KleeWorkerPool::Worker *KleeWorkerPool::acquireWorker() {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    Worker *acquired = nullptr;
+    for (auto &worker : workers) {
+        if (worker.downUntil > now) {
+            continue;
+        }
+        if (acquired == nullptr || worker.runsInFlight < acquired->runsInFlight) {
+            acquired = &worker;
+        }
+    }
+    if (acquired != nullptr) {
+        ++acquired->runsInFlight;
+    }
+    return acquired;
+}
+
+void KleeWorkerPool::releaseWorker(Worker &worker, bool failed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    --worker.runsInFlight;
+    if (failed) {
+        worker.downUntil = std::chrono::steady_clock::now() + RETRY_DELAY;
+    }
+}
+
+testsgen::KleeRunRequest
+KleeWorkerPool::createRequest(const std::vector<std::string> &argvData,
+                              const fs::path &bitcodeFilePath,
+                              const std::optional<std::chrono::seconds> &timeout,
+                    const std::atomic_bool *stopFlag) {
+    testsgen::KleeRunRequest request;
+    auto bitcodeIt = std::find(argvData.begin(), argvData.end(), bitcodeFilePath.string());
+    // the first element is the executable name
+    for (auto it = std::next(argvData.begin()); it < bitcodeIt; ++it) {
+        bool isLocal = std::any_of(LOCAL_OPTION_PREFIXES.begin(), LOCAL_OPTION_PREFIXES.end(),
+                                   [&](const std::string &prefix) {
+                                       return StringUtils::startsWith(*it, prefix);
+                                   });
+        if (!isLocal) {
+            request.add_kleearguments(*it);
+        }
+    }
+    if (bitcodeIt != argvData.end()) {
+        for (auto it = std::next(bitcodeIt); it != argvData.end(); ++it) {
+            request.add_programarguments(*it);
+        }
+    }
+    request.set_bitcodehash(ArtifactStore::getInstance().put(bitcodeFilePath));
+    request.set_timeoutseconds(timeout.has_value() ? static_cast<int32_t>(timeout->count()) : 0);
+    return request;
+}
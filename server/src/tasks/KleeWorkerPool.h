@@ -0,0 +1,92 @@
+#ifndef UNITTESTBOT_KLEEWORKERPOOL_H
+#define UNITTESTBOT_KLEEWORKERPOOL_H
+
+#include "utils/ExecutionResult.h"
+#include "utils/path/FileSystemPath.h"
+
+#include <grpcpp/grpcpp.h>
+#include <protobuf/testgen.grpc.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * Offloads KLEE runs to other UTBot servers (`--klee-workers`).
+ *
+ * A run goes to the available worker with the fewest runs in flight. A worker whose call
+ * fails is marked down and gets no runs for RETRY_DELAY, then it is tried again. Its linked
+ * bitcode is put into ArtifactStore and the worker gets only the content key, so workers
+ * on other hosts have to mount the same store. The worker returns files of its KLEE output directory, they are
+ * unpacked to the local one, so ktests are processed as if KLEE ran locally.
+ *
+ * Seeds are local to the server and aren't used by remote runs.
+ */
+class KleeWorkerPool {
+public:
+    static KleeWorkerPool &getInstance();
+
+    [[nodiscard]] bool isEnabled() const;
+
+    /**
+     * @brief Replaces workers of `--klee-workers`, no runs may be in flight.
+     *
+     * Used by tests to run KLEE on a worker in the same process.
+     */
+    void setWorkers(const std::vector<std::string> &addresses);
+
+    /**
+     * @brief Runs KLEE on a worker.
+     * @param argvData KLEE command line as made by KleeRunner, the bitcode file is its
+     * program.
+     * @param kleeOut local output directory, files of the remote one are written to it.
+     * @param stopFlag the run is cancelled on the worker when the flag is set, e.g. by
+     * another run of the searcher portfolio. Unlike a local run it brings back no ktests.
+     * @return result of the run or std::nullopt if no worker could run it, e.g. all of them
+     * are unavailable, then it has to be run locally.
+     * @throws CancellationException if the request is cancelled during the run.
+     */
+    std::optional<ExecUtils::ExecutionResult> run(const std::vector<std::string> &argvData,
+                                                  const fs::path &bitcodeFilePath,
+                                                  const fs::path &kleeOut,
+                                                  const std::optional<std::chrono::seconds> &timeout,
+                                                  const std::atomic_bool *stopFlag = nullptr);
+
+private:
+    struct Worker {
+        std::string address;
+        std::unique_ptr<testsgen::KleeWorkerService::Stub> stub;
+        size_t runsInFlight = 0;
+        std::chrono::steady_clock::time_point downUntil{};
+    };
+
+    KleeWorkerPool();
+
+    /**
+     * @return worker for a run or nullptr if all of them are down.
+     */
+    Worker *acquireWorker();
+
+    void releaseWorker(Worker &worker, bool failed);
+
+    static testsgen::KleeRunRequest createRequest(const std::vector<std::string> &argvData,
+                                                  const fs::path &bitcodeFilePath,
+                                                  const std::optional<std::chrono::seconds> &timeout);
+
+    /**
+     * Time given to the worker over the KLEE timeout to dump ktests and send them back.
+     */
+    static constexpr std::chrono::seconds DEADLINE_MARGIN{ 60 };
+    static constexpr std::chrono::milliseconds CANCELLATION_CHECK_INTERVAL{ 100 };
+    static constexpr std::chrono::seconds RETRY_DELAY{ 30 };
+
+    mutable std::mutex mutex;
+    std::vector<Worker> workers;
+};
+
+
+#endif // UNITTESTBOT_KLEEWORKERPOOL_H
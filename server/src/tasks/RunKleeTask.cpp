@@ -1,5 +1,6 @@
 #include "RunKleeTask.h"
 
+#include "JobScheduler.h"
 #include "TimeExecStatistics.h"
 #include "utils/ExecUtils.h"
 
@@ -30,23 +31,37 @@ void RunKleeTask::redirectMessage() const {
 
 ExecUtils::ExecutionResult RunKleeTask::run() {
     MEASURE_FUNCTION_EXECUTION_TIME
-    return BaseForkTask::run();
+    // runs holding memory already hold their slots, so a run never waits for a slot with memory reserved
+    auto slot = JobScheduler::getInstance().acquire();
+    admission = KleeMemoryGovernor::getInstance().admit();
+    if (const std::atomic_bool *governorStopFlag = admission.getStopFlag()) {
+        addStopFlag(governorStopFlag);
+    }
+    ExecUtils::ExecutionResult result = BaseForkTask::run();
+    admission = {};
+    return result;
 }
 
 void RunKleeTask::waitAfterSignal(int signalId) const {
-    if (signalId == 0) {
-        // Dump may take a while, so try and give the process extra time to clean up
-        for (int i = 0; i < DUMP_TIMEOUT_MILLISECONDS / TIMEOUT_MILLISECONDS; i++) {
-            std::this_thread::sleep_for(TIMEOUT_MILLISECONDS);
-            throwIfNoSuchProcess();
-        }
-    } else {
-        std::this_thread::sleep_for(TIMEOUT_MILLISECONDS);
-    }
+    // First SIGTERM makes KLEE halt and dump its states, which may take a while,
+    // so try and give the process extra time to clean up
+    waitForExit(signalId == 0 ? DUMP_TIMEOUT_MILLISECONDS : TIMEOUT_MILLISECONDS);
+}
+
+void RunKleeTask::onChildStarted() {
+    // child process makes itself a leader of a new process group
+    admission.attach(pid);
 }
 
 int RunKleeTask::childProcessJob() {
-    return runKleeLambda();
+    std::vector<char *> arguments(argv, argv + argc);
+    std::string maxMemoryOption;
+    if (auto maxMemory = admission.getMaxMemoryMegabytes()) {
+        maxMemoryOption = "--max-memory=" + std::to_string(maxMemory.value());
+        // KLEE options have to precede the bitcode file
+        arguments.insert(arguments.begin() + 1, maxMemoryOption.data());
+    }
+    return run_klee(static_cast<int>(arguments.size()), arguments.data(), environ);
 }
 
 std::string RunKleeTask::collectAndCleanup() {
@@ -66,5 +81,5 @@ RunKleeTask::RunKleeTask(int argc,
                          char **argv,
                          const std::optional<std::chrono::seconds> &timeout)
     : BaseForkTask("KLEE", timeout, Paths::getKleeTmpLogFilePath(), { SIGTERM, SIGTERM, SIGKILL }, true, true),
-      runKleeLambda([=] { return run_klee(argc, argv, environ); }) {
+      argc(argc), argv(argv) {
 }
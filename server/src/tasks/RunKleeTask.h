@@ -1,6 +1,7 @@
 #ifndef UNITTESTBOT_RUNKLEETASK_H
 #define UNITTESTBOT_RUNKLEETASK_H
 #include "BaseForkTask.h"
+#include "KleeMemoryGovernor.h"
 #include "Paths.h"
 
 
@@ -8,6 +9,7 @@
  * Class that performs a fork, calls run_klee(argc, argv, environ)
  * in chind process, writes KLEE directory and dumps KLEE output
  * to DEBUG log. ::run() always returns empty output.
+ * The fork waits for admission of KleeMemoryGovernor.
  */
 class RunKleeTask : public BaseForkTask {
 public:
@@ -31,13 +33,16 @@ private:
     void stopMessage(int status) const override;
     void redirectMessage() const override;
     void waitAfterSignal(int signalId) const override;
+    void onChildStarted() override;
     int childProcessJob() override;
     std::string collectAndCleanup() override;
 
     static constexpr std::chrono::milliseconds DUMP_TIMEOUT_MILLISECONDS { 5'000 }; // 5s
     static constexpr std::chrono::milliseconds TIMEOUT_MILLISECONDS{ 100 }; // 100ms
 
-    std::function <int(void)> runKleeLambda;
+    int argc;
+    char **argv;
+    KleeMemoryGovernor::Admission admission;
 };
 
 
@@ -2,6 +2,7 @@
 
 #include "Paths.h"
 #include "building/BuildDatabase.h"
+#include "building/ProjectSessionCache.h"
 #include "exceptions/CompilationDatabaseException.h"
 #include "utils/CompilationUtils.h"
 
@@ -15,7 +16,8 @@ ProjectTestGen::ProjectTestGen(const testsgen::ProjectRequest &request,
                       testMode), request(&request) {
     fs::create_directories(projectContext.testDirPath);
     compileCommandsJsonPath = CompilationUtils::substituteRemotePathToCompileCommandsJsonPath(projectContext);
-    projectBuildDatabase = std::make_shared<ProjectBuildDatabase>(compileCommandsJsonPath, serverBuildDir, projectContext);
+    projectBuildDatabase = ProjectSessionCache::getInstance().getProjectBuildDatabase(
+        compileCommandsJsonPath, serverBuildDir, projectContext);
     targetBuildDatabase = std::make_shared<TargetBuildDatabase>(projectBuildDatabase.get(), request.targetpath());
     if (autoDetect) {
         autoDetectSourcePathsIfNotEmpty();
@@ -1,5 +1,14 @@
 #include "ExecUtils.h"
 
+#include "RequestEnvironment.h"
+#include "TimeExecStatistics.h"
+#include "tasks/JobScheduler.h"
+
+#include "loguru.h"
+
+#include <exception>
+#include <future>
+
 namespace ExecUtils {
     void throwIfCancelled() {
         auto context = RequestEnvironment::getServerContext();
@@ -8,6 +17,50 @@ namespace ExecUtils {
         }
     }
 
+    void runInParallel(size_t threadsCount, const std::function<void()> &work) {
+        std::vector<std::future<void>> workers = launchInParallel(threadsCount, work);
+        std::exception_ptr exception;
+        for (auto &worker : workers) {
+            try {
+                worker.get();
+            } catch (...) {
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+            }
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    std::vector<std::future<void>> launchInParallel(size_t threadsCount,
+                                                    std::function<void()> work,
+                                                    bool holdSlot) {
+        const std::optional<std::string> clientId = RequestEnvironment::clientId;
+        grpc::ServerContext *const serverContext = RequestEnvironment::serverContext;
+        const RequestEnvironment::Priority priority = RequestEnvironment::getPriority();
+        const auto trace = TimeExecStatistics::getTrace();
+        std::vector<std::future<void>> workers;
+        for (size_t i = 0; i < threadsCount; i++) {
+            workers.push_back(std::async(std::launch::async, [=]() {
+                if (clientId.has_value()) {
+                    RequestEnvironment::setClientId(clientId.value());
+                    loguru::set_thread_name(clientId->c_str());
+                }
+                RequestEnvironment::setServerContext(serverContext);
+                RequestEnvironment::setPriority(priority);
+                TimeExecStatistics::setTrace(trace);
+                JobScheduler::Slot slot;
+                if (holdSlot) {
+                    slot = JobScheduler::getInstance().acquire();
+                }
+                work();
+            }));
+        }
+        return workers;
+    }
+
     void toCArgumentsPtr(std::vector<std::string> &argv,
                          std::vector<std::string> &envp,
                          std::vector<char *> &cargv,
@@ -5,11 +5,23 @@
 #include "exceptions/CancellationException.h"
 #include "streams/IStreamWriter.h"
 #include "streams/ProgressWriter.h"
+#include "tasks/JobScheduler.h"
 #include "tasks/ShellExecTask.h"
 #include "ExecutionResult.h"
 
 #include <grpcpp/grpcpp.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
 #include "utils/path/FileSystemPath.h"
 
 /**
@@ -51,6 +63,178 @@ namespace ExecUtils {
         }
     }
 
+    /**
+     * @brief Runs the work on the given number of threads and waits for all of them.
+     *
+     * Threads inherit client id and server context of the calling thread, so they log to the
+     * same client and observe cancellation. The first exception thrown by any of the threads is
+     * rethrown.
+     */
+    void runInParallel(size_t threadsCount, const std::function<void()> &work);
+
+    /**
+     * @brief Starts the work on the given number of threads set up as in runInParallel.
+     * @param holdSlot whether each thread holds a JobScheduler slot for its whole life,
+     * otherwise the work takes slots itself.
+     * @return futures of the threads, the caller has to wait for them.
+     */
+    std::vector<std::future<void>> launchInParallel(size_t threadsCount,
+                                                    std::function<void()> work,
+                                                    bool holdSlot = true);
+
+    /**
+     * @brief Parallel version of doWorkWithProgress.
+     * @param makeWorker is called once on each thread and returns the functor processing
+     * elements on that thread, so state which can't be shared by threads lives in the functor.
+     */
+    template <typename Iterable, typename WorkerFactory>
+    void doWorkWithProgressInParallel(Iterable &&iterable,
+                                      ProgressWriter const *progressWriter,
+                                      std::string const &message,
+                                      WorkerFactory &&makeWorker) {
+        std::vector<decltype(&*std::begin(iterable))> items;
+        for (auto &&it : iterable) {
+            items.push_back(&it);
+        }
+        size_t size = items.size();
+        progressWriter->writeProgress(message);
+        size_t threadsCount =
+            std::min<size_t>(size, std::max(std::thread::hardware_concurrency(), 1u));
+        std::atomic_size_t nextItem = 0;
+        std::atomic_bool failed = false;
+        std::mutex progressMutex;
+        size_t step = 0;
+        runInParallel(threadsCount, [&]() {
+            auto worker = makeWorker();
+            while (!failed) {
+                size_t index = nextItem++;
+                if (index >= size) {
+                    return;
+                }
+                try {
+                    throwIfCancelled();
+                    worker(*items[index]);
+                } catch (...) {
+                    failed = true;
+                    throw;
+                }
+                std::lock_guard<std::mutex> lock(progressMutex);
+                progressWriter->writeProgress(message, (100.0 * step) / size);
+                ++step;
+            }
+        });
+    }
+
+    /**
+     * @brief Produces results of items on worker threads ahead of their consumer.
+     *
+     * The consumer takes results on its own thread in the order of items, so the output
+     * doesn't depend on the number of threads or on the order in which producers finish.
+     * Producers run at most `window` items ahead of the last taken one, which bounds the
+     * memory of results waiting to be consumed. Worker threads are set up as in runInParallel.
+     *
+     * Each item is produced in its own JobScheduler slot, so producers waiting for the
+     * consumer don't hold slots and jobs started by a producer run in its slot.
+     *
+     * Exception of a producer is rethrown by take() of its item. The destructor stops the
+     * producers and waits for the started ones, e.g. if the consumer has thrown.
+     */
+    template <typename Result>
+    class OrderedPipeline {
+    public:
+        OrderedPipeline(size_t size,
+                        size_t threadsCount,
+                        size_t window,
+                        std::function<Result(size_t)> produce)
+            : size(size), window(std::max<size_t>(window, 1)), produce(std::move(produce)),
+              slots(size) {
+            threadsCount = std::min(threadsCount, size);
+            if (threadsCount == 0) {
+                return;
+            }
+            workers = launchInParallel(threadsCount, [this]() { work(); }, false);
+        }
+
+        OrderedPipeline(const OrderedPipeline &) = delete;
+        OrderedPipeline &operator=(const OrderedPipeline &) = delete;
+
+        ~OrderedPipeline() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopped = true;
+            }
+            changed.notify_all();
+            for (auto &worker : workers) {
+                worker.wait();
+            }
+        }
+
+        /**
+         * @brief Waits for the result of the item and lets producers go further.
+         * @throws the exception thrown by the producer of the item.
+         */
+        Result take(size_t index) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return slots[index].has_value(); });
+            Slot slot = std::move(slots[index].value());
+            slots[index].reset();
+            consumed = std::max(consumed, index + 1);
+            lock.unlock();
+            changed.notify_all();
+            if (slot.exception) {
+                std::rethrow_exception(slot.exception);
+            }
+            return std::move(slot.result.value());
+        }
+
+    private:
+        struct Slot {
+            std::optional<Result> result;
+            std::exception_ptr exception;
+        };
+
+        const size_t size;
+        const size_t window;
+        const std::function<Result(size_t)> produce;
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<std::optional<Slot>> slots;
+        size_t nextItem = 0;
+        size_t consumed = 0;
+        bool stopped = false;
+        std::vector<std::future<void>> workers;
+
+        void work() {
+            while (true) {
+                size_t index;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() {
+                        return stopped || nextItem >= size || nextItem < consumed + window;
+                    });
+                    if (stopped || nextItem >= size) {
+                        return;
+                    }
+                    index = nextItem++;
+                }
+                Slot slot;
+                try {
+                    auto jobSlot = JobScheduler::getInstance().acquire();
+                    throwIfCancelled();
+                    slot.result.emplace(produce(index));
+                } catch (...) {
+                    slot.exception = std::current_exception();
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    slots[index].emplace(std::move(slot));
+                }
+                changed.notify_all();
+            }
+        }
+    };
+
     void toCArgumentsPtr(std::vector<std::string> &argv,
                          std::vector<std::string> &envp,
                          std::vector<char *> &cargv,
@@ -2,8 +2,10 @@
 
 #include "exceptions/FileSystemException.h"
 
+#include <algorithm>
 #include <fstream>
 #include <system_error>
+#include <sys/stat.h>
 #include "Paths.h"
 
 namespace FileSystemUtils {
@@ -50,6 +52,48 @@ namespace FileSystemUtils {
         return directories;
     }
 
+    size_t evictLeastRecentlyUsed(const fs::path &directory, uintmax_t capacityInBytes) {
+        if (!fs::exists(directory)) {
+            return 0;
+        }
+        struct FileUsage {
+            fs::path path;
+            time_t lastUse;
+            uintmax_t size;
+        };
+        std::vector<FileUsage> files;
+        uintmax_t totalSize = 0;
+        for (const auto &entry : fs::recursive_directory_iterator(directory)) {
+            struct stat fileStat {};
+            if (!entry.is_regular_file() || stat(entry.path().c_str(), &fileStat) != 0) {
+                continue;
+            }
+            time_t lastUse = std::max(fileStat.st_atime, fileStat.st_mtime);
+            uintmax_t size = static_cast<uintmax_t>(fileStat.st_size);
+            files.push_back({ entry.path(), lastUse, size });
+            totalSize += size;
+        }
+        if (totalSize <= capacityInBytes) {
+            return 0;
+        }
+        std::sort(files.begin(), files.end(), [](const FileUsage &lhs, const FileUsage &rhs) {
+            return lhs.lastUse < rhs.lastUse;
+        });
+        size_t removed = 0;
+        for (const auto &file : files) {
+            if (totalSize <= capacityInBytes) {
+                break;
+            }
+            std::error_code ec;
+            std::filesystem::remove(file.path.c_str(), ec);
+            if (!ec) {
+                totalSize -= file.size;
+                removed++;
+            }
+        }
+        return removed;
+    }
+
     DirectoryIterator::DirectoryIterator(const fs::path &directory) : fs::directory_iterator(directory) {
         this->directory = directory;
     }
@@ -14,6 +14,18 @@ namespace FileSystemUtils {
 
     std::vector<fs::path> recursiveDirectories(const fs::path &root);
 
+    /**
+     * @brief Removes least recently used files of the directory until its total size fits
+     * into the given capacity.
+     *
+     * Last use of a file is the latest of its access and modification times. Files may be
+     * read concurrently by other processes, as removal does not affect opened descriptors.
+     * @param directory - the directory which is traversed recursively.
+     * @param capacityInBytes - the maximum total size of files.
+     * @return number of removed files.
+     */
+    size_t evictLeastRecentlyUsed(const fs::path &directory, uintmax_t capacityInBytes);
+
     class DirectoryIterator : public fs::directory_iterator {
         fs::path directory;
 
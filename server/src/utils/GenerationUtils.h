@@ -36,7 +36,8 @@ namespace GenerationUtils {
         static_assert(std::is_base_of<BaseTestGen, TestGenT>::value,
                       "Type parameter must derive from BaseTestGen");
         ServerUtils::setThreadOptions(ctx, true);
-        auto testsWriter = std::make_unique<CLITestsWriter>();
+        // callers use only status and build databases of the returned generator
+        auto testsWriter = std::make_unique<CLITestsWriter>(true);
         auto testGen = std::make_unique<TestGenT>(request, testsWriter.get(), true);
         Status status =
             Server::TestsGenServiceImpl::ProcessBaseTestRequest(*testGen, testsWriter.get());
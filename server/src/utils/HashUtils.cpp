@@ -4,6 +4,9 @@
 
 #include "Synchronizer.h"
 
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MD5.h>
+
 namespace HashUtils {
     std::size_t PathHash::operator()(const fs::path &path) const {
         return fs::hash_value(path);
@@ -23,4 +26,16 @@ namespace HashUtils {
                     testMethod.is32bits);
         return seed;
     }
+
+    std::string stableHash(const std::vector<std::string> &values) {
+        llvm::MD5 hash;
+        for (const std::string &value : values) {
+            hash.update(llvm::StringRef(value));
+            // separates values, so {"ab", "c"} and {"a", "bc"} differ
+            hash.update(llvm::StringRef("\0", 1));
+        }
+        llvm::MD5::MD5Result result;
+        hash.final(result);
+        return result.digest().str().str();
+    }
 }
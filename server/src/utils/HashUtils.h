@@ -3,6 +3,9 @@
 
 #include "utils/path/FileSystemPath.h"
 
+#include <string>
+#include <vector>
+
 namespace tests {
     struct TestMethod;
 }
@@ -34,6 +37,13 @@ namespace HashUtils {
     struct TestMethodHash {
         std::size_t operator()(const tests::TestMethod &testMethod) const;
     };
+
+    /**
+     * @brief Hashes the values with MD5. Unlike std::hash, the result is the same in every
+     * build of the server, so it may name files kept between runs.
+     * @return hex digest.
+     */
+    std::string stableHash(const std::vector<std::string> &values);
 }
 
 #endif //UNITTESTBOT_HASHUTILS_H
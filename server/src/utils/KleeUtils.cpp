@@ -14,6 +14,7 @@
 #include <future>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <thread>
 #include <unistd.h>
 #include <unordered_map>
 #include <unordered_set>
@@ -105,4 +106,24 @@ namespace KleeUtils {
         }
         return "--process-number=5";
     }
+
+    std::vector<SearcherConfig> searcherPortfolio(bool useDeterministicSearcher) {
+        if (useDeterministicSearcher) {
+            return { { "dfs", { "--search=dfs" } } };
+        }
+        static const std::vector<SearcherConfig> portfolio = {
+            { "default", {} },
+            { "dfs", { "--search=dfs" } },
+            { "covnew", { "--search=nurs:covnew" } },
+            { "bfs", { "--search=bfs" } },
+            { "random_path_1", { "--search=random-path", "--rng-initial-seed=1" } },
+            { "random_state_2", { "--search=random-state", "--rng-initial-seed=2" } },
+            { "md2u", { "--search=nurs:md2u", "--rng-initial-seed=3" } },
+            { "random_path_4", { "--search=random-path", "--rng-initial-seed=4" } }
+        };
+        size_t size = std::max<size_t>(Commands::kleePortfolioSize, 1);
+        size = std::min<size_t>(size, std::max(std::thread::hardware_concurrency(), 1u));
+        size = std::min(size, portfolio.size());
+        return { portfolio.begin(), portfolio.begin() + size };
+    }
 }
@@ -4,6 +4,7 @@
 #include <grpcpp/server_context.h>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "Tests.h"
 
@@ -22,6 +23,23 @@ namespace KleeUtils {
     std::string postSymbolicVariable(const std::string &variableName);
 
     std::string processNumberOption();
+
+    /**
+     * KLEE searcher configuration used as a member of a portfolio run.
+     */
+    struct SearcherConfig {
+        std::string name;
+        std::vector<std::string> flags;
+    };
+
+    /**
+     * @brief Returns searcher configurations to be run in parallel for a single entrypoint.
+     *
+     * The first configuration is always the one used outside of portfolio mode. The size of
+     * portfolio is limited by `--klee-portfolio-size` server option and by the number of cores.
+     * @param useDeterministicSearcher deterministic generation implies a single DFS run.
+     */
+    std::vector<SearcherConfig> searcherPortfolio(bool useDeterministicSearcher);
 }
 
 #endif // CORE_KLEEUTIL_H
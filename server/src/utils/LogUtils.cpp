@@ -51,8 +51,8 @@ namespace LogUtils {
             }
             for (const auto& client : outdatedClients) {
                 service.linkedWithClient.erase(client);
-                service.openedChannel[client].store(false, std::memory_order_release);
-                service.openedGTestChannel[client].store(false, std::memory_order_release);
+                // channels are marked as not opened once their RPCs return
+                service.closeLogChannels(client);
             }
         }
     }
@@ -19,6 +19,9 @@ namespace ServerUtils {
     using json = nlohmann::json;
 
     void setThreadOptions(grpc::ServerContext *context, bool testMode) {
+        // gRPC threads are reused, nothing may leak from the previous request
+        RequestEnvironment::setPriority(RequestEnvironment::Priority::INTERACTIVE);
+        RequestEnvironment::setProgressWriter(nullptr);
         if (!CollectionUtils::containsKey(context->client_metadata(), "clientid")) {
             if (testMode) {
                 std::string client = LogUtils::TEST_CLIENT;
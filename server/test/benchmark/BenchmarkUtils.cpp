@@ -0,0 +1,22 @@
+#include "BenchmarkUtils.h"
+
+#include "TestUtils.h"
+
+namespace benchmarkUtils {
+    fs::path getPerformanceProjectRelativePath() {
+        return fs::path("..") / "integration-tests" / "perfomance-test";
+    }
+
+    fs::path getPerformanceProjectSourcePath(int64_t functionCount) {
+        return fs::weakly_canonical(fs::current_path().parent_path() /
+                                    getPerformanceProjectRelativePath() / "src" /
+                                    ("func" + std::to_string(functionCount) + ".c"));
+    }
+
+    void prepareProjects() {
+        testUtils::tryExecGetBuildCommands(getPerformanceProjectRelativePath(), COMPILER);
+        for (const std::string &suite : BUILD_DATABASE_SUITES) {
+            testUtils::tryExecGetBuildCommands(testUtils::getRelativeTestSuitePath(suite), COMPILER);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef UNITTESTBOT_BENCHMARKUTILS_H
+#define UNITTESTBOT_BENCHMARKUTILS_H
+
+#include "utils/CompilationUtils.h"
+
+#include "utils/path/FileSystemPath.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace benchmarkUtils {
+    /**
+     * Sizes of the generated performance project: its source file src/funcN.c has N functions.
+     * Files are made by generate.py when the project is configured.
+     */
+    inline const std::vector<int64_t> FUNCTION_COUNTS = { 10, 50, 100, 500 };
+
+    /**
+     * Test suites whose build databases are loaded, from the smallest to the largest one.
+     */
+    inline const std::vector<std::string> BUILD_DATABASE_SUITES = { "small-project", "server" };
+
+    inline const CompilationUtils::CompilerName COMPILER = CompilationUtils::CompilerName::CLANG;
+
+    /**
+     * @return path of the performance project relative to the server directory.
+     */
+    fs::path getPerformanceProjectRelativePath();
+
+    fs::path getPerformanceProjectSourcePath(int64_t functionCount);
+
+    /**
+     * @brief Gets build commands of all benchmarked projects and builds them.
+     * @throws std::runtime_error if a project can't be built.
+     */
+    void prepareProjects();
+}
+
+#endif // UNITTESTBOT_BENCHMARKUTILS_H
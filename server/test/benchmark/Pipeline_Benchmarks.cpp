@@ -0,0 +1,408 @@
+#include "BenchmarkUtils.h"
+#include "TestUtils.h"
+
+#include "FeaturesFilter.h"
+#include "KleeGenerator.h"
+#include "KleeRunner.h"
+#include "ReturnTypesFetcher.h"
+#include "Server.h"
+#include "Synchronizer.h"
+#include "building/Linker.h"
+#include "building/ProjectBuildDatabase.h"
+#include "clang-utils/SourceToHeaderRewriter.h"
+#include "coverage/CoverageAndResultsGenerator.h"
+#include "coverage/CoverageTool.h"
+#include "fetchers/Fetcher.h"
+#include "printers/TestsPrinter.h"
+#include "streams/coverage/ServerCoverageAndResultsWriter.h"
+#include "streams/tests/ServerTestsWriter.h"
+#include "stubs/StubGen.h"
+#include "stubs/StubsCollector.h"
+#include "testgens/FileTestGen.h"
+#include "utils/FileSystemUtils.h"
+
+#include <benchmark/benchmark.h>
+
+/**
+ * Benchmarks of test generation stages, see main.cpp for usage.
+ *
+ * Every stage is measured on the generated performance project for a file of each size from
+ * benchmarkUtils::FUNCTION_COUNTS. Stages run on real artifacts: everything a stage needs is
+ * prepared by the preceding stages outside of the timed region, and UTBot files of the project
+ * are removed before each iteration, so no iteration is served from the artifacts or KLEE
+ * results of another one. Stages fork compilers and KLEE, so wall time is reported.
+ */
+namespace {
+    using benchmarkUtils::COMPILER;
+
+    // iterations of heavy stages, use --benchmark_repetitions for more samples
+    constexpr int64_t STAGE_ITERATIONS = 3;
+
+    const std::string PROJECT_NAME = "benchmark-project";
+
+    /**
+     * A file of the performance project and everything its generation needs.
+     */
+    class PerformanceFile {
+    public:
+        explicit PerformanceFile(int64_t functionCount)
+            : projectPath(fs::weakly_canonical(fs::current_path().parent_path() /
+                                               benchmarkUtils::getPerformanceProjectRelativePath())),
+              buildDirRelativePath(CompilationUtils::getBuildDirectoryName(COMPILER)),
+              sourcePath(benchmarkUtils::getPerformanceProjectSourcePath(functionCount)),
+              writer(nullptr, false) {
+        }
+
+        /**
+         * @brief Removes artifacts and tests left by previous iterations.
+         */
+        void clear() const {
+            FileSystemUtils::removeAll(projectPath / buildDirRelativePath /
+                                       CompilationUtils::UTBOT_FILES_DIR_NAME);
+            FileSystemUtils::removeAll(getTestDirPath());
+        }
+
+        [[nodiscard]] fs::path getTestDirPath() const {
+            return projectPath / "tests";
+        }
+
+        [[nodiscard]] std::unique_ptr<FileRequest> createRequest() const {
+            return testUtils::createFileRequest(PROJECT_NAME, projectPath, buildDirRelativePath,
+                                                { projectPath, projectPath / "src" }, sourcePath);
+        }
+
+        const fs::path projectPath;
+        const std::string buildDirRelativePath;
+        const fs::path sourcePath;
+        ServerTestsWriter writer;
+    };
+
+    /**
+     * Generation of a file advanced up to a given stage, in the same way as
+     * Server::TestsGenServiceImpl::ProcessBaseTestRequest does it.
+     */
+    class Generation {
+    public:
+        enum class Stage { KLEE_FILES_READY, KLEE_FILES_BUILT };
+
+        Generation(PerformanceFile &file, Stage stage)
+            : request(file.createRequest()),
+              testGen(*request, &file.writer, true) {
+            testGen.setTargetForSource(file.sourcePath);
+            Fetcher fetcher(Fetcher::Options::Value::ALL,
+                            testGen.getTargetBuildDatabase()->compilationDatabase, testGen.tests,
+                            &testGen.types, &sizeContext.maximumAlignment,
+                            testGen.compileCommandsJsonPath, false);
+            fetcher.fetch();
+            SourceToHeaderRewriter(testGen.projectContext,
+                                   testGen.getTargetBuildDatabase()->compilationDatabase,
+                                   fetcher.getStructsToDeclare(), testGen.serverBuildDir)
+                .generateTestHeaders(testGen.tests, testGen.progressWriter);
+            typesHandler = std::make_unique<types::TypesHandler>(testGen.types, sizeContext);
+            stubGen = std::make_unique<StubGen>(testGen);
+            Synchronizer synchronizer(&testGen, &sizeContext);
+            synchronizer.synchronize(*typesHandler);
+            FeaturesFilter::filter(testGen.settingsContext, *typesHandler, testGen.tests);
+            StubsCollector(*typesHandler).collect(testGen.tests);
+            generator = std::make_shared<KleeGenerator>(&testGen, *typesHandler, PathSubstitution{});
+            ReturnTypesFetcher{ &testGen }.fetch(testGen.progressWriter, synchronizer.getSourceFiles());
+            if (stage == Stage::KLEE_FILES_READY) {
+                return;
+            }
+            generator->buildKleeFiles(testGen.tests, nullptr);
+            generator->handleFailedFunctions(testGen.tests);
+        }
+
+        Generation(const Generation &) = delete;
+        Generation &operator=(const Generation &) = delete;
+
+        const std::unique_ptr<FileRequest> request;
+        FileTestGen testGen;
+        types::TypesHandler::SizeContext sizeContext;
+        std::unique_ptr<types::TypesHandler> typesHandler;
+        std::unique_ptr<StubGen> stubGen;
+        std::shared_ptr<KleeGenerator> generator;
+    };
+
+    /**
+     * @brief Runs the whole generation of the file.
+     * @return false and reports an error to the benchmark if generation failed.
+     */
+    bool generateTests(benchmark::State &state, PerformanceFile &file, FileTestGen &testGen) {
+        testGen.setTargetForSource(file.sourcePath);
+        Status status = Server::TestsGenServiceImpl::ProcessBaseTestRequest(testGen, &file.writer);
+        if (!status.ok()) {
+            state.SkipWithError(("Generation failed: " + status.error_message()).c_str());
+            return false;
+        }
+        return true;
+    }
+
+    tests::Tests &getTests(FileTestGen &testGen, const PerformanceFile &file) {
+        return testGen.tests.at(file.sourcePath);
+    }
+
+    /**
+     * @brief Drops everything KLEE results have added to the tests of the file.
+     */
+    void clearTestCases(tests::Tests &tests) {
+        for (auto it = tests.methods.begin(); it != tests.methods.end(); it++) {
+            it.value().testCases.clear();
+            it.value().suiteTestCases.clear();
+            it.value().codeText.clear();
+        }
+        tests.commentBlocks.clear();
+        tests.code.clear();
+    }
+
+    void setCounters(benchmark::State &state, size_t testsCount = 0) {
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.counters["functions"] = static_cast<double>(state.range(0));
+        if (testsCount != 0) {
+            state.counters["tests"] = static_cast<double>(testsCount);
+        }
+    }
+
+    void BM_ProjectBuildDatabaseLoad(benchmark::State &state, const fs::path &projectPath) {
+        auto projectContext = GrpcUtils::createProjectContext(
+            PROJECT_NAME, projectPath, projectPath / "tests",
+            CompilationUtils::getBuildDirectoryName(COMPILER));
+        utbot::ProjectContext context(*projectContext);
+        fs::path buildCommandsJsonPath =
+            CompilationUtils::substituteRemotePathToCompileCommandsJsonPath(context);
+        fs::path serverBuildDir = Paths::getUTBotBuildDir(context);
+        size_t filesCount = 0;
+        for (auto _ : state) {
+            // constructed directly, so the session cache doesn't serve later iterations
+            ProjectBuildDatabase buildDatabase(buildCommandsJsonPath, serverBuildDir, context);
+            filesCount = buildDatabase.compilationDatabase->getAllFiles().size();
+            benchmark::DoNotOptimize(filesCount);
+        }
+        state.counters["files"] = static_cast<double>(filesCount);
+    }
+
+    void BM_Fetcher(benchmark::State &state) {
+        PerformanceFile file(state.range(0));
+        file.clear();
+        for (auto _ : state) {
+            state.PauseTiming();
+            auto request = file.createRequest();
+            FileTestGen testGen(*request, &file.writer, true);
+            testGen.setTargetForSource(file.sourcePath);
+            types::TypesHandler::SizeContext sizeContext;
+            state.ResumeTiming();
+
+            Fetcher(Fetcher::Options::Value::ALL,
+                    testGen.getTargetBuildDatabase()->compilationDatabase, testGen.tests,
+                    &testGen.types, &sizeContext.maximumAlignment,
+                    testGen.compileCommandsJsonPath, false)
+                .fetch();
+        }
+        setCounters(state);
+    }
+
+    void BM_BuildKleeFiles(benchmark::State &state) {
+        PerformanceFile file(state.range(0));
+        for (auto _ : state) {
+            state.PauseTiming();
+            file.clear();
+            Generation generation(file, Generation::Stage::KLEE_FILES_READY);
+            state.ResumeTiming();
+
+            generation.generator->buildKleeFiles(generation.testGen.tests, nullptr);
+        }
+        setCounters(state);
+    }
+
+    void BM_LinkerPrepareArtifacts(benchmark::State &state) {
+        PerformanceFile file(state.range(0));
+        for (auto _ : state) {
+            state.PauseTiming();
+            file.clear();
+            Generation generation(file, Generation::Stage::KLEE_FILES_BUILT);
+            Linker linker{ generation.testGen, *generation.stubGen, nullptr, generation.generator };
+            state.ResumeTiming();
+
+            linker.prepareArtifacts();
+        }
+        setCounters(state);
+    }
+
+    void BM_Generation(benchmark::State &state) {
+        PerformanceFile file(state.range(0));
+        size_t testsCount = 0;
+        for (auto _ : state) {
+            state.PauseTiming();
+            file.clear();
+            auto request = file.createRequest();
+            FileTestGen testGen(*request, &file.writer, true);
+            state.ResumeTiming();
+
+            if (!generateTests(state, file, testGen)) {
+                break;
+            }
+            testsCount = testUtils::getNumberOfTests(testGen.tests);
+        }
+        setCounters(state, testsCount);
+    }
+
+    /**
+     * Reads KLEE results archived by a generation and decodes them into test cases.
+     */
+    void BM_KTestObjectParser(benchmark::State &state) {
+        PerformanceFile file(state.range(0));
+        file.clear();
+        auto request = file.createRequest();
+        FileTestGen testGen(*request, &file.writer, true);
+        if (!generateTests(state, file, testGen)) {
+            return;
+        }
+        tests::Tests generatedTests = getTests(testGen, file);
+        clearTestCases(generatedTests);
+        std::vector<std::pair<tests::TestMethod, std::vector<fs::path>>> kleeOuts;
+        for (auto it = generatedTests.methods.begin(); it != generatedTests.methods.end(); it++) {
+            const std::string &methodName = it.key();
+            fs::path seedsDir = Paths::kleeSeedsDirForMethod(testGen.projectContext,
+                                                             file.sourcePath, methodName);
+            if (!fs::exists(seedsDir)) {
+                continue;
+            }
+            std::vector<fs::path> runs;
+            for (const auto &entry : fs::directory_iterator(seedsDir)) {
+                if (fs::is_directory(entry.path())) {
+                    runs.push_back(entry.path());
+                }
+            }
+            kleeOuts.emplace_back(tests::TestMethod(methodName, {}, file.sourcePath, false),
+                                  std::move(runs));
+        }
+        types::TypesHandler::SizeContext sizeContext;
+        types::TypesHandler typesHandler{ testGen.types, sizeContext };
+        size_t testsCount = 0;
+        for (auto _ : state) {
+            state.PauseTiming();
+            tests::Tests tests = generatedTests;
+            state.ResumeTiming();
+
+            tests::KTestObjectParser parser(typesHandler);
+            for (const auto &[method, runs] : kleeOuts) {
+                tests::MethodKtests ktestChunk;
+                KleeRunner::processMethod(ktestChunk, tests, runs, method);
+                parser.parseKTest(ktestChunk, tests, testGen.methodNameToReturnTypeMap, false,
+                                  nullptr);
+            }
+
+            state.PauseTiming();
+            testsCount = 0;
+            for (auto it = tests.methods.begin(); it != tests.methods.end(); it++) {
+                testsCount += it.value().testCases.size();
+            }
+            state.ResumeTiming();
+        }
+        setCounters(state, testsCount);
+    }
+
+    void BM_TestsPrinter(benchmark::State &state) {
+        PerformanceFile file(state.range(0));
+        file.clear();
+        auto request = file.createRequest();
+        FileTestGen testGen(*request, &file.writer, true);
+        if (!generateTests(state, file, testGen)) {
+            return;
+        }
+        tests::Tests generatedTests = getTests(testGen, file);
+        types::TypesHandler::SizeContext sizeContext;
+        types::TypesHandler typesHandler{ testGen.types, sizeContext };
+        for (auto _ : state) {
+            state.PauseTiming();
+            tests::Tests tests = generatedTests;
+            for (auto it = tests.methods.begin(); it != tests.methods.end(); it++) {
+                it.value().codeText.clear();
+            }
+            tests.code.clear();
+            state.ResumeTiming();
+
+            printer::TestsPrinter testsPrinter(&typesHandler,
+                                               Paths::getSourceLanguage(tests.sourceFilePath));
+            for (auto it = tests.methods.begin(); it != tests.methods.end(); it++) {
+                if (!it.value().testCases.empty()) {
+                    testsPrinter.genCode(it.value(), std::nullopt, true);
+                }
+            }
+            testsPrinter.joinToFinalCode(tests, tests.testHeaderFilePath);
+            benchmark::DoNotOptimize(tests.code.data());
+        }
+        setCounters(state, testUtils::getNumberOfTests(testGen.tests));
+    }
+
+    /**
+     * Reads the coverage report of tests generated for the file. Building and running the tests
+     * is done once, before the measurement.
+     */
+    void BM_CoverageIngestion(benchmark::State &state) {
+        PerformanceFile file(state.range(0));
+        file.clear();
+        auto request = file.createRequest();
+        FileTestGen testGen(*request, &file.writer, true);
+        if (!generateTests(state, file, testGen)) {
+            return;
+        }
+        fs::path testFilePath = Paths::sourcePathToTestPath(testGen.projectContext, file.sourcePath);
+        auto coverageRequest = testUtils::createCoverageAndResultsRequest(
+            PROJECT_NAME, file.projectPath, file.getTestDirPath(), file.buildDirRelativePath,
+            GrpcUtils::createTestFilterForFile(testFilePath));
+        ServerCoverageAndResultsWriter coverageWriter(nullptr);
+        CoverageAndResultsGenerator coverageGenerator{ coverageRequest.get(), &coverageWriter };
+        utbot::SettingsContext settingsContext{ true, true, 15, 0, true, false };
+        Status status = coverageGenerator.generate(true, settingsContext);
+        if (!status.ok() || coverageGenerator.hasExceptions()) {
+            state.SkipWithError("Tests of the file can't be run with coverage");
+            return;
+        }
+
+        fs::path compileCommandsJsonPath =
+            CompilationUtils::substituteRemotePathToCompileCommandsJsonPath(testGen.projectContext);
+        auto coverageTool =
+            getCoverageTool(compileCommandsJsonPath, testGen.projectContext, &coverageWriter);
+        size_t coveredFiles = 0;
+        for (auto _ : state) {
+            Coverage::CoverageMap coverageMap = coverageTool->getCoverageInfo();
+            nlohmann::json totals = coverageTool->getTotals();
+            coveredFiles = coverageMap.size();
+            benchmark::DoNotOptimize(totals);
+        }
+        setCounters(state);
+        state.counters["files"] = static_cast<double>(coveredFiles);
+    }
+
+    void applyFunctionCounts(benchmark::internal::Benchmark *benchmark) {
+        for (int64_t functionCount : benchmarkUtils::FUNCTION_COUNTS) {
+            benchmark->Arg(functionCount);
+        }
+        benchmark->ArgName("functions")->Unit(benchmark::kMillisecond)->UseRealTime();
+    }
+
+    const bool buildDatabaseBenchmarksRegistered = [] {
+        std::vector<std::pair<std::string, fs::path>> projects = {
+            { "perfomance-test", benchmarkUtils::getPerformanceProjectRelativePath() }
+        };
+        for (const std::string &suite : benchmarkUtils::BUILD_DATABASE_SUITES) {
+            projects.emplace_back(suite, testUtils::getRelativeTestSuitePath(suite));
+        }
+        for (const auto &[name, relativePath] : projects) {
+            fs::path projectPath = fs::weakly_canonical(fs::current_path().parent_path() / relativePath);
+            benchmark::RegisterBenchmark(("BM_ProjectBuildDatabaseLoad/" + name).c_str(),
+                                         BM_ProjectBuildDatabaseLoad, projectPath)
+                ->Unit(benchmark::kMillisecond);
+        }
+        return true;
+    }();
+}
+
+BENCHMARK(BM_Fetcher)->Apply(applyFunctionCounts);
+BENCHMARK(BM_BuildKleeFiles)->Apply(applyFunctionCounts)->Iterations(STAGE_ITERATIONS);
+BENCHMARK(BM_LinkerPrepareArtifacts)->Apply(applyFunctionCounts)->Iterations(STAGE_ITERATIONS);
+BENCHMARK(BM_Generation)->Apply(applyFunctionCounts)->Iterations(STAGE_ITERATIONS);
+BENCHMARK(BM_KTestObjectParser)->Apply(applyFunctionCounts);
+BENCHMARK(BM_TestsPrinter)->Apply(applyFunctionCounts);
+BENCHMARK(BM_CoverageIngestion)->Apply(applyFunctionCounts);
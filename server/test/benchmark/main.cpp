@@ -0,0 +1,38 @@
+#include "BenchmarkUtils.h"
+#include "Paths.h"
+#include "utils/CLIUtils.h"
+#include "utils/ServerUtils.h"
+
+#include "loguru.h"
+
+#include <benchmark/benchmark.h>
+#include <llvm/Support/Signals.h>
+
+// Usage: ./UTBot_Benchmarks [--benchmark_filter=<regex>]
+//                           [--benchmark_out=<file> --benchmark_out_format=json]
+//                           [--verbosity trace|debug|info|warning|error]
+// Run from the build directory of the server, like UTBot_UnitTests.
+int main(int argc, char **argv) {
+    llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+
+    benchmark::Initialize(&argc, argv);
+
+    auto ctx = std::make_unique<grpc::ServerContext>();
+    ServerUtils::setThreadOptions(ctx.get(), true);
+
+    CLIUtils::setupLogger(argc, argv, false);
+
+    fs::path logFilePath = Paths::getBaseLogDir();
+    fs::path allLogPath = logFilePath / "benchmarks.log";
+    loguru::add_file(allLogPath.c_str(), loguru::Append, loguru::Verbosity_MAX);
+
+    try {
+        benchmarkUtils::prepareProjects();
+    } catch (std::runtime_error const &e) {
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -2,10 +2,17 @@
 
 #include "BaseTest.h"
 #include "KleeGenerator.h"
+#include "KleeRunner.h"
 #include "SettingsContext.h"
+#include "commands/Commands.h"
+#include "utils/KleeUtils.h"
 
 #include "utils/path/FileSystemPath.h"
 
+#include <algorithm>
+#include <set>
+#include <thread>
+
 namespace {
     using testsgen::TestsResponse;
 
@@ -71,4 +78,79 @@ namespace {
         auto actualFilePath = generator.defaultBuild(sourceFilePath);
         EXPECT_TRUE(fs::exists(actualFilePath.getOpt().value()));
     }
+
+    TEST(KleeGenErrors_Test, MethodsWithErrorsOnBoundaryLines) {
+        // line 1 is a header, f takes lines 2-3, g takes line 4, h writes nothing
+        std::string content = "#include <x.h>\nint f() {\n}\nint g() {}\n";
+        size_t fBegin = content.find("int f");
+        size_t gBegin = content.find("int g");
+        printer::KleePrinter::MethodOffsets offsets = { { "f", { fBegin, gBegin } },
+                                                        { "g", { gBegin, content.size() } },
+                                                        { "h", { content.size(), content.size() } } };
+        auto lineRanges = printer::KleePrinter::toLineRanges(content, offsets);
+        EXPECT_EQ(std::make_pair<size_t, size_t>(2, 3), lineRanges.at("f"));
+        EXPECT_EQ(std::make_pair<size_t, size_t>(4, 4), lineRanges.at("g"));
+        EXPECT_EQ(0, lineRanges.count("h"));
+
+        fs::path kleeFilePath = "/tmp/file_klee.cpp";
+        auto errorsAt = [&](size_t line) {
+            std::string output = "/build/file_klee.cpp:" + std::to_string(line) + ":5: error: oops\n";
+            return KleeGenerator::getMethodsWithErrors(output, kleeFilePath, lineRanges);
+        };
+        EXPECT_TRUE(errorsAt(1).empty());
+        EXPECT_EQ(std::unordered_set<std::string>{ "f" }, errorsAt(2));
+        EXPECT_EQ(std::unordered_set<std::string>{ "f" }, errorsAt(3));
+        EXPECT_EQ(std::unordered_set<std::string>{ "g" }, errorsAt(4));
+        EXPECT_TRUE(errorsAt(5).empty());
+        EXPECT_TRUE(KleeGenerator::getMethodsWithErrors(
+                        "/build/other.cpp:3:1: error: oops\n", kleeFilePath, lineRanges)
+                        .empty());
+    }
+
+    TEST(KleeRunner_Test, KtestInputKeyIgnoresAddresses) {
+        auto object = [](const std::string &name, const std::string &bytes, size_t address) {
+            return tests::UTBotKTestObject(name, { bytes.begin(), bytes.end() }, {}, address,
+                                           false);
+        };
+        EXPECT_EQ(KleeRunner::ktestInputKey({ object("a", "12", 100), object("b", "3", 200) }),
+                  KleeRunner::ktestInputKey({ object("a", "12", 300), object("b", "3", 400) }));
+        EXPECT_NE(KleeRunner::ktestInputKey({ object("a", "12", 100) }),
+                  KleeRunner::ktestInputKey({ object("a", "13", 100) }));
+        EXPECT_NE(KleeRunner::ktestInputKey({ object("a", "12", 100) }),
+                  KleeRunner::ktestInputKey({ object("b", "12", 100) }));
+        // names and bytes of adjacent objects can't be mixed up
+        EXPECT_NE(KleeRunner::ktestInputKey({ object("a", "12", 100), object("b", "3", 200) }),
+                  KleeRunner::ktestInputKey({ object("a", "1", 100), object("2b", "3", 200) }));
+        EXPECT_NE(KleeRunner::ktestInputKey({ object("a", "", 100), object("b", "", 200) }),
+                  KleeRunner::ktestInputKey({ object("a", "", 100) }));
+    }
+
+    TEST(KleeRunner_Test, SearcherPortfolioSize) {
+        const uint32_t kleePortfolioSize = Commands::kleePortfolioSize;
+        const size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+
+        Commands::kleePortfolioSize = 8;
+        auto deterministic = KleeUtils::searcherPortfolio(true);
+        ASSERT_EQ(1u, deterministic.size());
+        EXPECT_EQ("dfs", deterministic.front().name);
+
+        Commands::kleePortfolioSize = 0;
+        auto single = KleeUtils::searcherPortfolio(false);
+        ASSERT_EQ(1u, single.size());
+        // the first searcher is the one used without portfolio
+        EXPECT_EQ("default", single.front().name);
+        EXPECT_TRUE(single.front().flags.empty());
+
+        Commands::kleePortfolioSize = 100;
+        auto portfolio = KleeUtils::searcherPortfolio(false);
+        EXPECT_EQ(std::min<size_t>(cores, 8), portfolio.size());
+        EXPECT_EQ("default", portfolio.front().name);
+        std::set<std::string> names;
+        for (const auto &searcher : portfolio) {
+            names.insert(searcher.name);
+        }
+        EXPECT_EQ(portfolio.size(), names.size());
+
+        Commands::kleePortfolioSize = kleePortfolioSize;
+    }
 }
@@ -0,0 +1,374 @@
+#include "gtest/gtest.h"
+
+#include "RequestEnvironment.h"
+#include "commands/Commands.h"
+#include "streams/LogChannel.h"
+#include "streams/tests/ServerTestsWriter.h"
+#include "tasks/JobScheduler.h"
+#include "utils/ExecUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace std::chrono_literals;
+
+    /**
+     * Sets `--max-jobs` for the test and restores it afterwards.
+     */
+    class MaxJobsGuard {
+    public:
+        explicit MaxJobsGuard(uint32_t maxJobs) : previous(Commands::maxJobs) {
+            Commands::maxJobs = maxJobs;
+        }
+
+        ~MaxJobsGuard() {
+            Commands::maxJobs = previous;
+        }
+
+    private:
+        const uint32_t previous;
+    };
+
+    /**
+     * Collects written log messages, fails after the given number of writes.
+     */
+    class FakeLogWriter : public grpc::ServerWriterInterface<testsgen::LogEntry> {
+    public:
+        explicit FakeLogWriter(size_t writesBeforeFailure = SIZE_MAX)
+            : writesBeforeFailure(writesBeforeFailure) {
+        }
+
+        void SendInitialMetadata() override {
+        }
+
+        bool Write(const testsgen::LogEntry &logEntry, grpc::WriteOptions) override {
+            if (messages.size() == writesBeforeFailure) {
+                return false;
+            }
+            messages.push_back(logEntry.message());
+            if (onWrite) {
+                onWrite();
+            }
+            return true;
+        }
+
+        std::vector<std::string> messages;
+        // called after each write, e.g. to log while the client reads
+        std::function<void()> onWrite;
+
+    private:
+        const size_t writesBeforeFailure;
+    };
+
+    TEST(Parallel_Test, OrderedPipelineTakesResultsInOrder) {
+        const size_t size = 8;
+        ExecUtils::OrderedPipeline<size_t> pipeline(size, 4, 8, [](size_t index) {
+            // earlier items finish later
+            std::this_thread::sleep_for(std::chrono::milliseconds(10 * (size - index)));
+            return index * 10;
+        });
+        for (size_t i = 0; i < size; i++) {
+            EXPECT_EQ(i * 10, pipeline.take(i));
+        }
+    }
+
+    TEST(Parallel_Test, OrderedPipelineBoundsProducersByWindow) {
+        const size_t size = 12;
+        const size_t window = 2;
+        // incremented before take(), so it is never behind the pipeline's own counter
+        std::atomic_size_t aboutToTake = 0;
+        std::atomic_size_t maxAhead = 0;
+        ExecUtils::OrderedPipeline<size_t> pipeline(size, 4, window, [&](size_t index) {
+            size_t ahead = index + 1 - std::min(index + 1, aboutToTake.load());
+            size_t previous = maxAhead.load();
+            while (ahead > previous && !maxAhead.compare_exchange_weak(previous, ahead)) {
+            }
+            return index;
+        });
+        std::this_thread::sleep_for(50ms);
+        for (size_t i = 0; i < size; i++) {
+            ++aboutToTake;
+            EXPECT_EQ(i, pipeline.take(i));
+            std::this_thread::sleep_for(5ms);
+        }
+        EXPECT_LE(maxAhead.load(), window);
+    }
+
+    TEST(Parallel_Test, OrderedPipelineRethrowsExceptionOfItem) {
+        ExecUtils::OrderedPipeline<int> pipeline(5, 2, 5, [](size_t index) {
+            if (index == 2) {
+                throw std::runtime_error("item 2");
+            }
+            return static_cast<int>(index);
+        });
+        EXPECT_EQ(0, pipeline.take(0));
+        EXPECT_EQ(1, pipeline.take(1));
+        EXPECT_THROW(pipeline.take(2), std::runtime_error);
+        // the destructor waits for producers of the items which are never taken
+    }
+
+    TEST(Parallel_Test, PortfolioRunsInSlotOfPipelineProducer) {
+        // more files than jobs and several runs per file: the first run goes in the slot of
+        // its producer, the others only in free slots, so they neither wait for the slot held
+        // by their own producer nor exceed the limit
+        const size_t maxJobs = 3;
+        MaxJobsGuard maxJobsGuard(maxJobs);
+        const size_t size = 6;
+        const size_t portfolioSize = 3;
+        std::atomic_size_t runningCount = 0;
+        std::atomic_size_t maxRunningCount = 0;
+        std::atomic_size_t firstRunsCount = 0;
+        ExecUtils::OrderedPipeline<size_t> pipeline(size, 2, 4, [&](size_t index) {
+            EXPECT_TRUE(JobScheduler::holdsSlot());
+            const bool holdsSlot = JobScheduler::holdsSlot();
+            std::vector<std::future<void>> runs;
+            for (size_t i = 0; i < portfolioSize; i++) {
+                runs.push_back(std::async(std::launch::async, [&, holdsSlot, i]() {
+                    JobScheduler::InheritedSlot inheritedSlot(holdsSlot && i == 0);
+                    std::optional<JobScheduler::Slot> slot;
+                    if (i > 0) {
+                        slot = JobScheduler::getInstance().tryAcquire();
+                        if (!slot.has_value()) {
+                            return;
+                        }
+                    }
+                    auto nestedSlot = JobScheduler::getInstance().acquire();
+                    size_t running = ++runningCount;
+                    size_t maxRunning = maxRunningCount;
+                    while (running > maxRunning &&
+                           !maxRunningCount.compare_exchange_weak(maxRunning, running)) {
+                    }
+                    if (i == 0) {
+                        ++firstRunsCount;
+                    }
+                    std::this_thread::sleep_for(5ms);
+                    --runningCount;
+                }));
+            }
+            for (auto &run : runs) {
+                run.get();
+            }
+            return index;
+        });
+        for (size_t i = 0; i < size; i++) {
+            EXPECT_EQ(i, pipeline.take(i));
+        }
+        EXPECT_EQ(size, firstRunsCount.load());
+        EXPECT_LE(maxRunningCount.load(), maxJobs);
+    }
+
+    TEST(Parallel_Test, JobSchedulerTryAcquire) {
+        MaxJobsGuard maxJobsGuard(1);
+        {
+            auto slot = JobScheduler::getInstance().tryAcquire();
+            ASSERT_TRUE(slot.has_value());
+            EXPECT_TRUE(JobScheduler::holdsSlot());
+            // the thread holds a slot, so it gets an empty one
+            EXPECT_TRUE(JobScheduler::getInstance().tryAcquire().has_value());
+            auto other = std::async(std::launch::async, []() {
+                return JobScheduler::getInstance().tryAcquire().has_value();
+            });
+            EXPECT_FALSE(other.get());
+        }
+        EXPECT_FALSE(JobScheduler::holdsSlot());
+        auto other = std::async(std::launch::async, []() {
+            return JobScheduler::getInstance().tryAcquire().has_value();
+        });
+        EXPECT_TRUE(other.get());
+    }
+
+    /**
+     * Starts a job of the client which records the order in which jobs get their slots.
+     */
+    std::future<void> startJob(const std::string &clientId,
+                               RequestEnvironment::Priority priority,
+                               std::mutex &orderMutex,
+                               std::vector<std::string> &order) {
+        return std::async(std::launch::async, [&, clientId, priority]() {
+            RequestEnvironment::setClientId(clientId);
+            RequestEnvironment::setPriority(priority);
+            auto slot = JobScheduler::getInstance().acquire();
+            {
+                std::lock_guard<std::mutex> lock(orderMutex);
+                order.push_back(clientId);
+            }
+            std::this_thread::sleep_for(10ms);
+        });
+    }
+
+    TEST(Parallel_Test, JobSchedulerReusesSlotOnSameThread) {
+        MaxJobsGuard maxJobsGuard(1);
+        EXPECT_FALSE(JobScheduler::holdsSlot());
+        {
+            auto slot = JobScheduler::getInstance().acquire();
+            EXPECT_TRUE(JobScheduler::holdsSlot());
+            // the only slot is taken: a job of another thread waits, a nested one doesn't
+            auto otherThreadJob = std::async(std::launch::async, []() {
+                auto otherSlot = JobScheduler::getInstance().acquire();
+            });
+            EXPECT_EQ(std::future_status::timeout, otherThreadJob.wait_for(50ms));
+            auto nestedSlot = JobScheduler::getInstance().acquire();
+            EXPECT_TRUE(JobScheduler::holdsSlot());
+            slot = JobScheduler::Slot();
+            // the slot is released once, so the waiting job gets it
+            ASSERT_EQ(std::future_status::ready, otherThreadJob.wait_for(10s));
+        }
+        EXPECT_FALSE(JobScheduler::holdsSlot());
+    }
+
+    TEST(Parallel_Test, JobSchedulerRunsInteractiveJobsFirst) {
+        MaxJobsGuard maxJobsGuard(1);
+        std::mutex orderMutex;
+        std::vector<std::string> order;
+        auto slot = JobScheduler::getInstance().acquire();
+        auto batchJob =
+            startJob("batch", RequestEnvironment::Priority::BATCH, orderMutex, order);
+        std::this_thread::sleep_for(50ms);
+        auto interactiveJob =
+            startJob("interactive", RequestEnvironment::Priority::INTERACTIVE, orderMutex, order);
+        std::this_thread::sleep_for(50ms);
+        slot = JobScheduler::Slot();
+        batchJob.get();
+        interactiveJob.get();
+        EXPECT_EQ(std::vector<std::string>({ "interactive", "batch" }), order);
+    }
+
+    TEST(Parallel_Test, JobSchedulerPrefersClientWithFewerJobs) {
+        MaxJobsGuard maxJobsGuard(2);
+        std::mutex orderMutex;
+        std::vector<std::string> order;
+        std::promise<void> busyJobDone;
+        std::promise<void> busyJobStarted;
+        // client "busy" runs a job for the whole test
+        auto busyJob = std::async(std::launch::async, [&]() {
+            RequestEnvironment::setClientId("busy");
+            auto slot = JobScheduler::getInstance().acquire();
+            busyJobStarted.set_value();
+            busyJobDone.get_future().wait();
+        });
+        busyJobStarted.get_future().wait();
+        auto slot = JobScheduler::getInstance().acquire();
+        auto busyClientJob =
+            startJob("busy", RequestEnvironment::Priority::INTERACTIVE, orderMutex, order);
+        std::this_thread::sleep_for(50ms);
+        auto idleClientJob =
+            startJob("idle", RequestEnvironment::Priority::INTERACTIVE, orderMutex, order);
+        std::this_thread::sleep_for(50ms);
+        // the released slot goes to the client running no jobs, though it came later
+        slot = JobScheduler::Slot();
+        idleClientJob.get();
+        busyClientJob.get();
+        busyJobDone.set_value();
+        busyJob.get();
+        EXPECT_EQ(std::vector<std::string>({ "idle", "busy" }), order);
+    }
+
+    TEST(Parallel_Test, LogChannelWritesMessagesQueuedBeforeClose) {
+        LogChannel channel("client", 8);
+        channel.push("first");
+        channel.push("second");
+        channel.close();
+        channel.push("after close");
+        FakeLogWriter writer;
+        channel.drainTo(&writer);
+        EXPECT_EQ(std::vector<std::string>({ "first", "second" }), writer.messages);
+    }
+
+    TEST(Parallel_Test, LogChannelReportsDroppedMessages) {
+        LogChannel channel("client", 2);
+        for (int i = 0; i < 5; i++) {
+            channel.push(std::to_string(i));
+        }
+        channel.close();
+        FakeLogWriter writer;
+        channel.drainTo(&writer);
+        // the notice doesn't wait for the messages queued before the drops
+        EXPECT_EQ(std::vector<std::string>(
+                      { "3 log messages were dropped, the client reads logs too slowly\n", "0",
+                        "1" }),
+                  writer.messages);
+    }
+
+    TEST(Parallel_Test, LogChannelReportsMessagesDroppedDuringWrite) {
+        LogChannel channel("client", 2);
+        channel.push("0");
+        channel.push("1");
+        FakeLogWriter writer;
+        writer.onWrite = [&]() {
+            if (writer.messages.size() == 1) {
+                for (int i = 2; i < 6; i++) {
+                    channel.push(std::to_string(i));
+                }
+                channel.close();
+            }
+        };
+        channel.drainTo(&writer);
+        EXPECT_EQ(std::vector<std::string>(
+                      { "0", "2 log messages were dropped, the client reads logs too slowly\n",
+                        "1", "2", "3" }),
+                  writer.messages);
+    }
+
+    TEST(Parallel_Test, LogChannelStopsOnFailedWrite) {
+        LogChannel channel("client", 8);
+        auto drained = std::async(std::launch::async, [&channel]() {
+            FakeLogWriter writer(1);
+            channel.drainTo(&writer);
+            return writer.messages;
+        });
+        channel.push("first");
+        channel.push("second");
+        // the channel is closed by the failed write, so this returns without close()
+        ASSERT_EQ(std::future_status::ready, drained.wait_for(10s));
+        EXPECT_EQ(std::vector<std::string>({ "first" }), drained.get());
+    }
+
+    TEST(Parallel_Test, DoWorkWithProgressInParallelProcessesEveryItemOnce) {
+        ServerTestsWriter writer(nullptr, false);
+        std::vector<int> items(100);
+        for (size_t i = 0; i < items.size(); i++) {
+            items[i] = static_cast<int>(i);
+        }
+        std::mutex mutex;
+        std::vector<int> processed;
+        std::atomic_size_t workersCount = 0;
+        ExecUtils::doWorkWithProgressInParallel(items, &writer, "Processing", [&]() {
+            ++workersCount;
+            return [&](int item) {
+                std::lock_guard<std::mutex> lock(mutex);
+                processed.push_back(item);
+            };
+        });
+        std::sort(processed.begin(), processed.end());
+        EXPECT_EQ(items, processed);
+        EXPECT_GE(workersCount.load(), 1u);
+        EXPECT_LE(workersCount.load(), std::max(std::thread::hardware_concurrency(), 1u));
+    }
+
+    TEST(Parallel_Test, DoWorkWithProgressInParallelRethrowsAndStops) {
+        ServerTestsWriter writer(nullptr, false);
+        std::vector<int> items(1000, 0);
+        std::atomic_size_t processedCount = 0;
+        EXPECT_THROW(ExecUtils::doWorkWithProgressInParallel(items, &writer, "Processing", [&]() {
+                         return [&](int) {
+                             if (processedCount++ == 10) {
+                                 throw std::runtime_error("failed item");
+                             }
+                         };
+                     }),
+                     std::runtime_error);
+        // workers stop taking items after the failure
+        EXPECT_LT(processedCount.load(), items.size());
+    }
+}
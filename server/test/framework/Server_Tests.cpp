@@ -4,15 +4,20 @@
 #include "KleeGenerator.h"
 #include "ProjectContext.h"
 #include "Server.h"
+#include "building/ProjectSessionCache.h"
 #include "clang-utils/SourceToHeaderRewriter.h"
+#include "commands/Commands.h"
 #include "coverage/CoverageAndResultsGenerator.h"
 #include "printers/HeaderPrinter.h"
 #include "printers/TestMakefilesPrinter.h"
 #include "printers/SourceWrapperPrinter.h"
+#include "tasks/KleeWorkerPool.h"
 #include "utils/FileSystemUtils.h"
 #include "utils/ServerUtils.h"
 
 #include "utils/path/FileSystemPath.h"
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <tuple>
 
@@ -864,6 +869,159 @@ namespace {
         checkAlignment(testGen);
     }
 
+    /**
+     * KLEE worker service of another server, counts runs sent to it.
+     */
+    class CountingKleeWorkerService final : public testsgen::KleeWorkerService::Service {
+    public:
+        grpc::Status RunKlee(grpc::ServerContext *context,
+                             const testsgen::KleeRunRequest *request,
+                             testsgen::KleeRunResponse *response) override {
+            ++runsCount;
+            return service.RunKlee(context, request, response);
+        }
+
+        std::atomic_size_t runsCount = 0;
+
+    private:
+        Server::KleeWorkerServiceImpl service{ true };
+    };
+
+    TEST_F(Server_Test, Klee_Worker_Test) {
+        using Ktest = std::vector<std::pair<std::string, std::vector<char>>>;
+        auto generateKtests = [&]() {
+            auto request = createSnippetRequest(projectName, suitePath, snippet_c);
+            auto testGen = SnippetTestGen(*request, writer.get(), TESTMODE);
+            // otherwise the archived results of the previous run are reused and KLEE isn't run
+            fs::remove_all(Paths::getKleeSeedsDir(testGen.projectContext));
+            Status status = Server::TestsGenServiceImpl::ProcessBaseTestRequest(testGen, writer.get());
+            EXPECT_TRUE(status.ok()) << status.error_message();
+            std::vector<Ktest> ktests;
+            for (const auto &[filePath, tests] : testGen.tests) {
+                for (const auto &[methodName, method] : tests.methods) {
+                    for (const auto &testCase : method.testCases) {
+                        Ktest ktest;
+                        for (const auto &object : testCase.objects) {
+                            ktest.emplace_back(object.name, object.bytes);
+                        }
+                        ktests.push_back(std::move(ktest));
+                    }
+                }
+            }
+            std::sort(ktests.begin(), ktests.end());
+            return ktests;
+        };
+        auto localKtests = generateKtests();
+
+        // the second server runs in this process, so it shares the artifact store
+        CountingKleeWorkerService workerService;
+        int workerPort = 0;
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &workerPort);
+        builder.RegisterService(&workerService);
+        std::unique_ptr<grpc::Server> workerServer = builder.BuildAndStart();
+        ASSERT_NE(nullptr, workerServer);
+        ASSERT_NE(0, workerPort);
+        KleeWorkerPool::getInstance().setWorkers({ "127.0.0.1:" + std::to_string(workerPort) });
+        auto remoteKtests = generateKtests();
+        KleeWorkerPool::getInstance().setWorkers({});
+        workerServer->Shutdown();
+
+        EXPECT_GT(workerService.runsCount.load(), 0u);
+        EXPECT_FALSE(localKtests.empty());
+        EXPECT_EQ(localKtests, remoteKtests);
+    }
+
+    TEST_F(Server_Test, Klee_Worker_Project_Test) {
+        std::string suite = "char";
+        setSuite(suite);
+        CountingKleeWorkerService workerService;
+        int workerPort = 0;
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &workerPort);
+        builder.RegisterService(&workerService);
+        std::unique_ptr<grpc::Server> workerServer = builder.BuildAndStart();
+        ASSERT_NE(nullptr, workerServer);
+        ASSERT_NE(0, workerPort);
+
+        // project requests run KLEE in interactive mode, their methods go to workers one by one
+        auto request = createProjectRequest(projectName, suitePath, buildDirRelativePath, srcPaths,
+                                            GrpcUtils::UTBOT_AUTO_TARGET_PATH);
+        auto testGen = ProjectTestGen(*request, writer.get(), TESTMODE);
+        fs::remove_all(Paths::getKleeSeedsDir(testGen.projectContext));
+        KleeWorkerPool::getInstance().setWorkers({ "127.0.0.1:" + std::to_string(workerPort) });
+        Status status = Server::TestsGenServiceImpl::ProcessBaseTestRequest(testGen, writer.get());
+        KleeWorkerPool::getInstance().setWorkers({});
+        workerServer->Shutdown();
+        ASSERT_TRUE(status.ok()) << status.error_message();
+
+        EXPECT_GT(workerService.runsCount.load(), 0u);
+        testUtils::checkMinNumberOfTests(testGen.tests, 6);
+    }
+
+    TEST_F(Server_Test, Klee_Seeds_Test) {
+        auto generate = [&](int kleeTimeout) {
+            auto projectRequest = createProjectRequest(
+                projectName, suitePath, buildDirRelativePath, srcPaths,
+                GrpcUtils::UTBOT_AUTO_TARGET_PATH, false, true, kleeTimeout);
+            auto request =
+                GrpcUtils::createFileRequest(std::move(projectRequest), assertion_failures_c);
+            auto testGen = FileTestGen(*request, writer.get(), TESTMODE);
+            testGen.setTargetForSource(assertion_failures_c);
+            Status status = Server::TestsGenServiceImpl::ProcessBaseTestRequest(testGen, writer.get());
+            EXPECT_TRUE(status.ok()) << status.error_message();
+            return testGen;
+        };
+        auto testGen = generate(60);
+        fs::path seedsDir = Paths::kleeSeedsDirForMethod(testGen.projectContext,
+                                                         assertion_failures_c, "buggy_function2");
+        // error descriptors are archived next to ktests, KLEE has to skip them
+        bool hasErrorDescriptors = false;
+        for (const auto &entry : fs::recursive_directory_iterator(seedsDir)) {
+            hasErrorDescriptors |= entry.path().extension() == ".err";
+        }
+        EXPECT_TRUE(hasErrorDescriptors);
+
+        // another timeout changes the results key, but not the signature, so the archived
+        // runs are passed to KLEE as seed directories instead of being reused
+        auto seededTestGen = generate(59);
+        checkAssertionFailures_C(seededTestGen);
+    }
+
+    TEST_F(Server_Test, Project_Session_Cache_Test) {
+        const uint32_t cacheSize = Commands::projectSessionCacheSize;
+        Commands::projectSessionCacheSize = 1;
+        utbot::ProjectContext projectContext(projectName, suitePath, getTestDirectory(),
+                                             buildDirRelativePath);
+        auto &cache = ProjectSessionCache::getInstance();
+
+        // snapshots are kept alive, so a new database can't get the address of a dropped one
+        auto snapshot = cache.getSnapshot(projectContext);
+        auto hit = cache.getSnapshot(projectContext);
+        EXPECT_EQ(snapshot, hit);
+        EXPECT_NE(snapshot.get(), cache.getProjectBuildDatabase(projectContext).get());
+
+        fs::path compileCommandsPath =
+            CompilationUtils::substituteRemotePathToCompileCommandsJsonPath(projectContext) /
+            "compile_commands.json";
+        fs::last_write_time(compileCommandsPath,
+                            fs::last_write_time(compileCommandsPath) + std::chrono::seconds(1));
+        auto changed = cache.getSnapshot(projectContext);
+        EXPECT_NE(snapshot, changed);
+        EXPECT_EQ(changed, cache.getSnapshot(projectContext));
+
+        // the other test directory is another session, the only slot goes to it
+        utbot::ProjectContext otherProjectContext(projectName, suitePath,
+                                                  getTestDirectory() / "other",
+                                                  buildDirRelativePath);
+        auto other = cache.getSnapshot(otherProjectContext);
+        EXPECT_NE(changed, other);
+        auto evicted = cache.getSnapshot(projectContext);
+        EXPECT_NE(changed, evicted);
+
+        Commands::projectSessionCacheSize = cacheSize;
+    }
+
     class Parameterized_Server_Test : public Server_Test,
                                       public testing::WithParamInterface<std::tuple<CompilerName>> {
     protected:
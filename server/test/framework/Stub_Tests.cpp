@@ -3,6 +3,7 @@
 #include "BaseTest.h"
 #include "streams/stubs/StubsWriter.h"
 #include "stubs/StubSourcesFinder.h"
+#include "stubs/StubsIndex.h"
 #include "utils/FileSystemUtils.h"
 #include "utils/path/FileSystemPath.h"
 #include "coverage/CoverageAndResultsGenerator.h"
@@ -300,4 +301,46 @@ namespace {
             checkStubFileEqualsTo(sum_stub_c, suitePath / "modified" / "sum_stub_sync.c");
         }
     }
+
+    TEST_F(Stub_Test, Stubs_Index_Test) {
+        fs::path stubsDir = Paths::getStubsDirPath(projectContext);
+        fs::path first_stub_c = stubsDir / "first_stub.c";
+        fs::path second_stub_c = stubsDir / "second_stub.c";
+        FileSystemUtils::writeToFile(first_stub_c, "int f() { return 0; }\n");
+        FileSystemUtils::writeToFile(second_stub_c, "int g() { return 0; }\n");
+        fs::remove(Paths::getStubsIndexPath(projectContext));
+        {
+            StubsIndex stubsIndex(projectContext);
+            EXPECT_FALSE(stubsIndex.isUpToDate(first_stub_c));
+            stubsIndex.update(first_stub_c, { "f", "g" });
+            stubsIndex.update(second_stub_c, { "g" });
+            stubsIndex.save();
+        }
+
+        StubsIndex stubsIndex(projectContext);
+        EXPECT_TRUE(stubsIndex.isUpToDate(first_stub_c));
+        EXPECT_TRUE(stubsIndex.isUpToDate(second_stub_c));
+        EXPECT_EQ(CollectionUtils::FileSet({ first_stub_c }), stubsIndex.findStubFiles({ "f" }));
+        EXPECT_EQ(CollectionUtils::FileSet({ first_stub_c, second_stub_c }),
+                  stubsIndex.findStubFiles({ "g" }));
+        EXPECT_TRUE(stubsIndex.findStubFiles({ "h" }).empty());
+
+        // reindexing replaces the symbols of the stub
+        stubsIndex.update(first_stub_c, { "f" });
+        EXPECT_EQ(CollectionUtils::FileSet({ second_stub_c }), stubsIndex.findStubFiles({ "g" }));
+        stubsIndex.remove(second_stub_c);
+        EXPECT_FALSE(stubsIndex.isUpToDate(second_stub_c));
+        EXPECT_TRUE(stubsIndex.findStubFiles({ "g" }).empty());
+
+        // a stub edited by user has to be parsed again
+        fs::last_write_time(first_stub_c,
+                            fs::last_write_time(first_stub_c) + std::chrono::seconds(10));
+        EXPECT_FALSE(stubsIndex.isUpToDate(first_stub_c));
+
+        // a broken index is dropped
+        FileSystemUtils::writeToFile(Paths::getStubsIndexPath(projectContext), "{ broken");
+        StubsIndex brokenStubsIndex(projectContext);
+        EXPECT_TRUE(brokenStubsIndex.findStubFiles({ "f" }).empty());
+        fs::remove(Paths::getStubsIndexPath(projectContext));
+    }
 }
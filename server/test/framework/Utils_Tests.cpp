@@ -1,16 +1,22 @@
 #include "gtest/gtest.h"
 
 #include "TestUtils.h"
+#include "Tests.h"
+#include "TimeExecStatistics.h"
+#include "commands/Commands.h"
 #include "utils/CollectionUtils.h"
 #include "utils/CompilationUtils.h"
 #include "utils/ExecUtils.h"
+#include "utils/FileSystemUtils.h"
 #include "utils/StringUtils.h"
 
 #include <algorithm>
 #include <climits>
 #include <limits>
 #include <random>
+#include <stdexcept>
 #include <string>
+#include <utime.h>
 
 namespace {
     auto projectPath = fs::current_path().parent_path() / testUtils::getRelativeTestSuitePath("server");
@@ -473,6 +479,26 @@ namespace {
         EXPECT_LE(diff.count(), 10.);
     }
 
+    TEST(Utils_Test, EvictLeastRecentlyUsed) {
+        fs::path cacheDir = fs::current_path() / "lru_eviction_test";
+        if (fs::exists(cacheDir)) {
+            FileSystemUtils::removeAll(cacheDir);
+        }
+        for (int i = 0; i < 4; i++) {
+            fs::path entry = cacheDir / ("entry" + std::to_string(i));
+            FileSystemUtils::writeToFile(entry, std::string(100, 'x'));
+            utimbuf times{ 1000 + i, 1000 + i };
+            utime(entry.c_str(), &times);
+        }
+        EXPECT_EQ(2, FileSystemUtils::evictLeastRecentlyUsed(cacheDir, 250));
+        EXPECT_FALSE(fs::exists(cacheDir / "entry0"));
+        EXPECT_FALSE(fs::exists(cacheDir / "entry1"));
+        EXPECT_TRUE(fs::exists(cacheDir / "entry2"));
+        EXPECT_TRUE(fs::exists(cacheDir / "entry3"));
+        EXPECT_EQ(0, FileSystemUtils::evictLeastRecentlyUsed(cacheDir, 250));
+        FileSystemUtils::removeAll(cacheDir);
+    }
+
     TEST(Utils_Test, AddExt) {
         fs::path filePath = projectPath / "basic_functions.c";
         EXPECT_EQ(projectPath / "basic_functions.bc", Paths::replaceExtension(filePath, ".bc"));
@@ -518,4 +544,86 @@ namespace {
     TEST(Utils_Test, AddExtension) {
         EXPECT_EQ(Paths::addExtension("/a/b", ".cpp"), "/a/b.cpp");
     }
+
+    TEST(Utils_Test, TimeExecStatisticsHistogramBuckets) {
+        // call sites are registered for GetMetrics, so it must outlive the test
+        static TimeExecStatistics::CallSite callSite("Utils_Tests.cpp", "histogram", 0);
+        const size_t last = TimeExecStatistics::HISTOGRAM_BUCKETS - 1;
+        const std::vector<std::pair<uint64_t, size_t>> durationsAndBuckets = {
+            { 0, 0 },    { 999, 0 },  { 1000, 1 }, { 1999, 1 },
+            { 2000, 2 }, { 3999, 2 }, { 4000, 3 }, { 1ull << 40, last }
+        };
+        uint64_t total = 0;
+        for (const auto &[microseconds, _] : durationsAndBuckets) {
+            callSite.record(microseconds);
+            total += microseconds;
+        }
+        std::vector<uint64_t> expected(TimeExecStatistics::HISTOGRAM_BUCKETS);
+        for (const auto &[_, bucket] : durationsAndBuckets) {
+            ++expected[bucket];
+        }
+        for (size_t i = 0; i < TimeExecStatistics::HISTOGRAM_BUCKETS; i++) {
+            EXPECT_EQ(expected[i], callSite.histogram[i].load()) << "bucket " << i;
+        }
+        EXPECT_EQ(durationsAndBuckets.size(), callSite.count.load());
+        EXPECT_EQ(total, callSite.totalMicroseconds.load());
+        EXPECT_EQ(1ull << 40, callSite.maxMicroseconds.load());
+    }
+
+    TEST(Utils_Test, TimeExecStatisticsRequestScopeDropsTraceOnException) {
+        const bool traceRequests = Commands::traceRequests;
+        Commands::traceRequests = true;
+        try {
+            TimeExecStatistics::RequestScope requestStatistics;
+            EXPECT_NE(nullptr, TimeExecStatistics::getTrace());
+            throw std::runtime_error("request failed");
+        } catch (const std::runtime_error &) {
+        }
+        Commands::traceRequests = traceRequests;
+        EXPECT_EQ(nullptr, TimeExecStatistics::getTrace());
+    }
+
+    TEST(Utils_Test, ReleaseGeneratedCodeKeepsSummary) {
+        const std::string longText(1000, 'x');
+        tests::Tests fileTests;
+        fileTests.sourceFilePath = "/project/lib/a.c";
+        fileTests.testSourceFilePath = "/project/tests/lib/a_test.cpp";
+        fileTests.code = longText;
+        fileTests.headerCode = longText;
+        fileTests.commentBlocks = { longText };
+        fileTests.stubs = longText;
+        fileTests.errorMethodsNumber = 1;
+        fileTests.regressionMethodsNumber = 2;
+        tests::Tests::MethodDescription method;
+        method.name = "f";
+        method.stubsText = longText;
+        method.codeText[tests::Tests::DEFAULT_SUITE_NAME] = longText;
+        method.codeText[tests::Tests::ERROR_SUITE_NAME] = longText;
+        method.suiteTestCases[tests::Tests::DEFAULT_SUITE_NAME] = { 0, 1 };
+        fileTests.methods.emplace("f", method);
+
+        fileTests.releaseGeneratedCode();
+
+        // memory is given back, not only cleared
+        EXPECT_LT(fileTests.code.capacity(), longText.size());
+        EXPECT_LT(fileTests.headerCode.capacity(), longText.size());
+        EXPECT_EQ(0u, fileTests.commentBlocks.capacity());
+        EXPECT_LT(fileTests.stubs.capacity(), longText.size());
+        EXPECT_EQ("/project/lib/a.c", fileTests.sourceFilePath);
+        EXPECT_EQ("/project/tests/lib/a_test.cpp", fileTests.testSourceFilePath);
+        EXPECT_EQ(1u, fileTests.errorMethodsNumber);
+        EXPECT_EQ(2u, fileTests.regressionMethodsNumber);
+        ASSERT_EQ(1u, fileTests.methods.size());
+        const auto &releasedMethod = fileTests.methods.at("f");
+        EXPECT_EQ("f", releasedMethod.name);
+        EXPECT_LT(releasedMethod.stubsText.capacity(), longText.size());
+        EXPECT_EQ(0u, releasedMethod.testCases.capacity());
+        // suites stay, so code of both default suites is still found by name
+        ASSERT_EQ(2u, releasedMethod.codeText.size());
+        for (const auto &[suiteName, code] : releasedMethod.codeText) {
+            EXPECT_TRUE(code.empty()) << suiteName;
+        }
+        ASSERT_EQ(1u, releasedMethod.suiteTestCases.size());
+        EXPECT_EQ(0u, releasedMethod.suiteTestCases.at(tests::Tests::DEFAULT_SUITE_NAME).capacity());
+    }
 }